@@ -0,0 +1,202 @@
+/** @file
+ *
+ * @brief Microbenchmarks for the hot paths of the @c shared_buffer classes.
+ *
+ * The scenarios are construction, copying (reference counting, single threaded and
+ * contended between threads), appending, moving a @c mutable_shared_buffer into a
+ * @c const_shared_buffer, comparison, and hashing, each for small, medium, and large
+ * buffer sizes where the size matters.
+ *
+ * Catch2 benchmarking is used, so the usual Catch2 command line options apply, e.g.
+ * @c --benchmark-samples, or a tag such as @c [refcount] to run a subset.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include <cstddef> // std::byte, std::size_t
+#include <cstdint> // std::uint16_t, etc
+#include <string>
+#include <vector>
+#include <thread>
+#include <array>
+#include <utility> // std::move
+
+#include "buffer/shared_buffer.hpp"
+#include "buffer/local_shared_buffer.hpp"
+
+namespace {
+
+struct size_case {
+  const char* name;
+  std::size_t size;
+};
+
+constexpr std::array<size_case, 3u> sizes { { { "small", 16u }, { "medium", 1024u },
+                                              { "large", 64u * 1024u } } };
+
+std::vector<std::byte> make_bytes(std::size_t sz) {
+  std::vector<std::byte> vec(sz);
+  for (std::size_t i = 0u; i < sz; ++i) {
+    vec[i] = static_cast<std::byte>(i * 31u);
+  }
+  return vec;
+}
+
+std::string bench_name(const char* what, const size_case& sc) {
+  return std::string(what) + " (" + sc.name + ", " + std::to_string(sc.size) + " bytes)";
+}
+
+constexpr int copies_per_thread { 100000 };
+
+// each thread copies (and destroys) one of the buffers many times; with a single
+// buffer all threads contend on the same reference count
+std::size_t copy_in_threads(const std::vector<chops::const_shared_buffer>& bufs, int num_threads) {
+  std::vector<std::thread> thrs;
+  std::vector<std::size_t> totals(num_threads, 0u);
+  for (int t = 0; t < num_threads; ++t) {
+    thrs.emplace_back([&bufs, &totals, t] {
+      const auto& buf { bufs[static_cast<std::size_t>(t) % bufs.size()] };
+      std::size_t tot { 0u };
+      for (int i = 0; i < copies_per_thread; ++i) {
+        chops::const_shared_buffer cp(buf);
+        tot += cp.size();
+      }
+      totals[t] = tot;
+    } );
+  }
+  for (auto& thr : thrs) {
+    thr.join();
+  }
+  std::size_t sum { 0u };
+  for (auto tot : totals) {
+    sum += tot;
+  }
+  return sum;
+}
+
+}
+
+TEST_CASE ( "Shared buffer construction", "[construct]" ) {
+  for (const auto& sc : sizes) {
+    auto bytes { make_bytes(sc.size) };
+    BENCHMARK ( bench_name("mutable_shared_buffer copy from bytes", sc) ) {
+      return chops::mutable_shared_buffer(bytes.data(), bytes.size());
+    };
+    BENCHMARK ( bench_name("const_shared_buffer copy from bytes", sc) ) {
+      return chops::const_shared_buffer(bytes.data(), bytes.size());
+    };
+    BENCHMARK ( bench_name("mutable_shared_buffer zero filled size", sc) ) {
+      return chops::mutable_shared_buffer(sc.size);
+    };
+  }
+  BENCHMARK ( "mutable_shared_buffer default (no allocation)" ) {
+    return chops::mutable_shared_buffer();
+  };
+}
+
+TEST_CASE ( "Shared buffer copy and reference count", "[refcount]" ) {
+  auto bytes { make_bytes(16u) };
+  chops::const_shared_buffer csb(bytes.data(), bytes.size());
+  chops::mutable_shared_buffer msb(bytes.data(), bytes.size());
+  chops::local_const_shared_buffer lcsb(bytes.data(), bytes.size());
+
+  BENCHMARK ( "const_shared_buffer copy" ) {
+    return chops::const_shared_buffer(csb);
+  };
+  BENCHMARK ( "mutable_shared_buffer copy" ) {
+    return chops::mutable_shared_buffer(msb);
+  };
+  BENCHMARK ( "local_const_shared_buffer copy (non-atomic count)" ) {
+    return chops::local_const_shared_buffer(lcsb);
+  };
+
+  int num_threads { static_cast<int>(std::thread::hardware_concurrency()) };
+  num_threads = num_threads < 2 ? 2 : (num_threads > 8 ? 8 : num_threads);
+  std::vector<chops::const_shared_buffer> one { csb };
+  std::vector<chops::const_shared_buffer> separate;
+  for (int t = 0; t < num_threads; ++t) {
+    separate.emplace_back(bytes.data(), bytes.size());
+  }
+  std::string thr_desc { std::to_string(num_threads) + " threads x " +
+                         std::to_string(copies_per_thread) + " copies" };
+
+  BENCHMARK ( "const_shared_buffer copy, contended, " + thr_desc ) {
+    return copy_in_threads(one, num_threads);
+  };
+  BENCHMARK ( "const_shared_buffer copy, uncontended, " + thr_desc ) {
+    return copy_in_threads(separate, num_threads);
+  };
+}
+
+TEST_CASE ( "Shared buffer append", "[append]" ) {
+  auto piece { make_bytes(64u) };
+  for (const auto& sc : sizes) {
+    BENCHMARK ( bench_name("append 64 byte pieces", sc) ) {
+      chops::mutable_shared_buffer msb;
+      while (msb.size() < sc.size) {
+        msb.append(piece.data(), piece.size());
+      }
+      return msb;
+    };
+    BENCHMARK ( bench_name("append 64 byte pieces, reserved", sc) ) {
+      chops::mutable_shared_buffer msb;
+      msb.reserve(sc.size + piece.size());
+      while (msb.size() < sc.size) {
+        msb.append(piece.data(), piece.size());
+      }
+      return msb;
+    };
+  }
+  BENCHMARK ( "append_be of header fields" ) {
+    chops::mutable_shared_buffer msb;
+    msb.append_be(std::uint16_t(0x0102), std::uint32_t(0x03040506), std::uint64_t(42u));
+    return msb;
+  };
+}
+
+TEST_CASE ( "Shared buffer move to const", "[move_to_const]" ) {
+  for (const auto& sc : sizes) {
+    auto bytes { make_bytes(sc.size) };
+    BENCHMARK_ADVANCED ( bench_name("mutable_shared_buffer moved into const_shared_buffer", sc) )
+                       (Catch::Benchmark::Chronometer meter) {
+      std::vector<chops::mutable_shared_buffer> msbs;
+      for (int i = 0; i < meter.runs(); ++i) {
+        msbs.emplace_back(bytes.data(), bytes.size());
+      }
+      meter.measure([&msbs] (int i) {
+        return chops::const_shared_buffer(std::move(msbs[i]));
+      } );
+    };
+  }
+}
+
+TEST_CASE ( "Shared buffer comparison and hashing", "[compare] [hash]" ) {
+  for (const auto& sc : sizes) {
+    auto bytes { make_bytes(sc.size) };
+    chops::const_shared_buffer lhs(bytes.data(), bytes.size());
+    chops::const_shared_buffer rhs(bytes.data(), bytes.size());
+    BENCHMARK ( bench_name("const_shared_buffer equality, separate storage", sc) ) {
+      return lhs == rhs;
+    };
+    BENCHMARK ( bench_name("const_shared_buffer ordering, separate storage", sc) ) {
+      return lhs < rhs;
+    };
+    BENCHMARK ( bench_name("hash of bytes", sc) ) {
+      return chops::detail::hash_bytes(bytes.data(), bytes.size());
+    };
+    lhs.hash();
+    BENCHMARK ( bench_name("const_shared_buffer cached hash", sc) ) {
+      return lhs.hash();
+    };
+  }
+}
+
@@ -55,7 +55,8 @@ int main() {
     constexpr char str1[] = "A cat in the hat.";
     const char* strptr = str1;
 
-    // add one char at a time, inside chops::repeat
+    // reserve space up front, then add one char at a time, inside chops::repeat
+    buf1.reserve(sizeof(str1));
     chops::repeat(sizeof(str1),
         [&] () { buf1.append(static_cast<std::byte> (*strptr++)); });
     
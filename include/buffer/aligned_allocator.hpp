@@ -0,0 +1,134 @@
+/** @file
+ *
+ * @brief An allocator providing buffer storage with a specific alignment, and
+ * optionally huge page backing for large buffers.
+ *
+ * @c std::vector storage (and therefore @c mutable_shared_buffer storage) is only
+ * aligned for @c std::max_align_t. Aligned SIMD loads, @c O_DIRECT file IO, and many
+ * DMA engines need more, typically a 64 byte cache line or a 4 KiB page. Using the
+ * @c aligned_allocator with @c basic_mutable_shared_buffer (or with the
+ * @c std::allocator_arg constructors of @c const_shared_buffer) guarantees that the
+ * @c data pointer has the requested alignment.
+ *
+ * When a huge page threshold is specified, allocations of at least that many bytes are
+ * aligned (and sized) to 2 MiB, and on Linux the kernel is asked to back them with
+ * transparent huge pages (@c MADV_HUGEPAGE). This reduces TLB misses for very large
+ * buffers. The request is advisory, and is silently skipped on other platforms.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef ALIGNED_ALLOCATOR_HPP_INCLUDED
+#define ALIGNED_ALLOCATOR_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <new> // operator new, std::align_val_t, std::bad_array_new_length
+#include <limits>
+#include <bit> // std::has_single_bit
+
+#if defined(__linux__)
+#include <sys/mman.h> // madvise
+#endif
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+/**
+ * @brief Size (and alignment) of huge page backed allocations.
+ */
+inline constexpr std::size_t huge_page_size = 2u * 1024u * 1024u;
+
+/**
+ * @brief Allocator with a minimum alignment, and optional huge page backing.
+ *
+ * The allocator is stateless, all instances compare equal.
+ *
+ * @tparam T Value type.
+ *
+ * @tparam Align Minimum alignment of every allocation, a power of two.
+ *
+ * @tparam HugeThreshold Allocations of at least this many bytes use huge pages; zero
+ * (the default) disables huge pages.
+ */
+template <typename T, std::size_t Align = 64u, std::size_t HugeThreshold = 0u>
+class aligned_allocator {
+public:
+  static_assert(std::has_single_bit(Align), "alignment must be a power of two");
+
+  using value_type = T;
+
+  static constexpr std::size_t alignment = Align > alignof(T) ? Align : alignof(T);
+
+  template <typename U>
+  struct rebind {
+    using other = aligned_allocator<U, Align, HugeThreshold>;
+  };
+
+private:
+  static constexpr bool use_huge(std::size_t bytes) noexcept {
+    return HugeThreshold != 0u && bytes >= HugeThreshold;
+  }
+
+  static constexpr std::size_t huge_size(std::size_t bytes) noexcept {
+    return (bytes + huge_page_size - 1u) / huge_page_size * huge_page_size;
+  }
+
+public:
+  aligned_allocator() noexcept = default;
+
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, Align, HugeThreshold>&) noexcept { }
+
+  T* allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    auto bytes { n * sizeof(T) };
+    if (use_huge(bytes)) {
+      auto sz { huge_size(bytes) };
+      auto p = ::operator new(sz, std::align_val_t{huge_page_size});
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+      ::madvise(p, sz, MADV_HUGEPAGE); // advisory, failure is not an error
+#endif
+      return static_cast<T*>(p);
+    }
+    return static_cast<T*>(::operator new(bytes, std::align_val_t{alignment}));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    auto bytes { n * sizeof(T) };
+    if (use_huge(bytes)) {
+      ::operator delete(static_cast<void*>(p), huge_size(bytes), std::align_val_t{huge_page_size});
+      return;
+    }
+    ::operator delete(static_cast<void*>(p), bytes, std::align_val_t{alignment});
+  }
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U, Align, HugeThreshold>&) const noexcept { return true; }
+};
+
+/**
+ * @brief A @c mutable_shared_buffer whose @c data pointer has the given alignment.
+ */
+template <std::size_t Align>
+using aligned_mutable_shared_buffer = basic_mutable_shared_buffer<aligned_allocator<std::byte, Align>>;
+
+/**
+ * @brief A page aligned @c mutable_shared_buffer, using huge pages for buffers of at
+ * least @c huge_page_size bytes.
+ */
+using huge_page_mutable_shared_buffer =
+    basic_mutable_shared_buffer<aligned_allocator<std::byte, 4096u, huge_page_size>>;
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,418 @@
+/** @file
+ *
+ * @brief Adapters between the @c shared_buffer classes and the Asio (Networking TS)
+ * buffer types: @c const_buffer / @c mutable_buffer conversions, a ConstBufferSequence
+ * for @c shared_buffer_sequence, and a @c dynamic_buffer model.
+ *
+ * The standalone Asio library is used if its headers are found, otherwise Boost.Asio
+ * is used. Defining @c SHARED_BUFFER_USE_BOOST_ASIO selects Boost.Asio even when the
+ * standalone headers are available. This is the only header in the library that has
+ * an Asio dependency.
+ *
+ * The usual way of reading into a @c mutable_shared_buffer is to wrap its
+ * @c std::vector (through @c get_byte_vec) with an Asio @c dynamic_buffer. That adapter
+ * resizes (and zero fills) the @c std::vector on every @c prepare, and erases the
+ * consumed bytes from the front (moving the remaining bytes) on every @c consume.
+ * The @c dynamic_shared_buffer class in this header avoids both:
+ *
+ * - The underlying buffer only grows, and its size is a high water mark. Bytes that
+ * are already there are handed out again by @c prepare (or @c grow) without being
+ * filled, so in a steady state there is no zero filling.
+ *
+ * - @c consume only advances an offset. The readable bytes are moved to the front
+ * only when @c prepare needs the space, and not at all when everything has been
+ * consumed (the common case for a framed protocol).
+ *
+ * @code
+ *   chops::dynamic_shared_buffer dbuf;
+ *   auto n = asio::read_until(sock, chops::asio_dynamic_buffer(dbuf), '\n');
+ *   // ... process the first n bytes of dbuf.readable()
+ *   dbuf.consume(n);
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef ASIO_SHARED_BUFFER_HPP_INCLUDED
+#define ASIO_SHARED_BUFFER_HPP_INCLUDED
+
+#if !defined(SHARED_BUFFER_USE_BOOST_ASIO) && __has_include(<asio/buffer.hpp>)
+#include "asio/buffer.hpp"
+#else
+#include <boost/asio/buffer.hpp>
+#endif
+
+#include <cstddef> // std::byte, std::size_t, std::ptrdiff_t
+#include <cstring> // std::memmove
+#include <iterator> // std::random_access_iterator_tag
+#include <span>
+#include <limits>
+#include <stdexcept> // std::length_error
+#include <algorithm> // std::min
+#include <utility> // std::move, std::declval
+#include <concepts> // std::same_as, std::convertible_to
+#include <type_traits> // std::remove_pointer_t, std::is_const_v
+
+#include "buffer/shared_buffer.hpp"
+#include "buffer/shared_buffer_sequence.hpp"
+
+namespace chops {
+
+namespace detail {
+
+#if !defined(SHARED_BUFFER_USE_BOOST_ASIO) && __has_include(<asio/buffer.hpp>)
+namespace asio_ns = ::asio;
+#else
+namespace asio_ns = ::boost::asio;
+#endif
+
+template <typename Buf>
+concept byte_data_buffer = requires (Buf& b) {
+  { b.data() } -> std::convertible_to<const std::byte*>;
+  { b.size() } -> std::convertible_to<std::size_t>;
+};
+
+} // end detail namespace
+
+/**
+ * @brief Return an Asio @c const_buffer referring to the bytes of a buffer.
+ *
+ * This works with any buffer with @c data and @c size methods, such as
+ * @c const_shared_buffer or @c mutable_shared_buffer.
+ *
+ * @note The Asio buffer does not keep the bytes alive; for async operations keep a copy
+ * of the @c const_shared_buffer in the completion handler, or use @c asio_buffers.
+ */
+template <detail::byte_data_buffer Buf>
+detail::asio_ns::const_buffer asio_buffer(const Buf& buf) noexcept {
+  return { buf.data(), buf.size() };
+}
+
+/**
+ * @brief Return an Asio @c mutable_buffer referring to the bytes of a mutable buffer.
+ *
+ * The buffer is not resized, so it must already have the size needed (e.g. through
+ * @c resize) before a read into it.
+ */
+template <detail::byte_data_buffer Buf>
+  requires (!std::is_const_v<std::remove_pointer_t<decltype(std::declval<Buf&>().data())>>)
+detail::asio_ns::mutable_buffer asio_buffer(Buf& buf) {
+  return { buf.data(), buf.size() };
+}
+
+/**
+ * @brief A ConstBufferSequence (as defined by Asio and the Networking TS) over the
+ * segments of a @c shared_buffer_sequence.
+ *
+ * The @c shared_buffer_sequence is held by value, and Asio copies the buffer sequence
+ * into an async operation, so the segments are kept alive until the operation
+ * completes without any additional handling in application code.
+ */
+class asio_buffer_sequence {
+public:
+  using value_type = detail::asio_ns::const_buffer;
+
+/**
+ * @brief Random access iterator providing an Asio @c const_buffer for each segment.
+ */
+  class const_iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = detail::asio_ns::const_buffer;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+  private:
+    shared_buffer_sequence::const_iterator m_it {};
+
+  public:
+    const_iterator() noexcept = default;
+    explicit const_iterator(shared_buffer_sequence::const_iterator it) noexcept : m_it(it) { }
+
+    reference operator*() const noexcept { return asio_buffer(*m_it); }
+    reference operator[](difference_type n) const noexcept { return asio_buffer(m_it[n]); }
+
+    const_iterator& operator++() noexcept { ++m_it; return *this; }
+    const_iterator operator++(int) noexcept { auto tmp { *this }; ++m_it; return tmp; }
+    const_iterator& operator--() noexcept { --m_it; return *this; }
+    const_iterator operator--(int) noexcept { auto tmp { *this }; --m_it; return tmp; }
+    const_iterator& operator+=(difference_type n) noexcept { m_it += n; return *this; }
+    const_iterator& operator-=(difference_type n) noexcept { m_it -= n; return *this; }
+
+    friend const_iterator operator+(const_iterator it, difference_type n) noexcept { return it += n; }
+    friend const_iterator operator+(difference_type n, const_iterator it) noexcept { return it += n; }
+    friend const_iterator operator-(const_iterator it, difference_type n) noexcept { return it -= n; }
+    friend difference_type operator-(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+      return lhs.m_it - rhs.m_it;
+    }
+    friend bool operator==(const const_iterator&, const const_iterator&) noexcept = default;
+    friend auto operator<=>(const const_iterator&, const const_iterator&) noexcept = default;
+  };
+
+  using iterator = const_iterator;
+
+private:
+  shared_buffer_sequence m_seq;
+
+public:
+
+/**
+ * @brief Construct from a @c shared_buffer_sequence, sharing the segments.
+ */
+  explicit asio_buffer_sequence(shared_buffer_sequence seq) noexcept : m_seq(std::move(seq)) { }
+
+/**
+ * @brief Construct a one segment sequence from a @c const_shared_buffer.
+ */
+  explicit asio_buffer_sequence(const const_shared_buffer& buf) : m_seq{buf} { }
+
+  const_iterator begin() const noexcept { return const_iterator(m_seq.begin()); }
+  const_iterator end() const noexcept { return const_iterator(m_seq.end()); }
+
+/**
+ * @brief Return the underlying @c shared_buffer_sequence.
+ */
+  const shared_buffer_sequence& sequence() const noexcept { return m_seq; }
+
+};
+
+/**
+ * @brief Create an @c asio_buffer_sequence for a gather write of a
+ * @c shared_buffer_sequence.
+ *
+ * @code
+ *   asio::async_write(sock, chops::asio_buffers(seq), handler);
+ * @endcode
+ */
+inline asio_buffer_sequence asio_buffers(shared_buffer_sequence seq) noexcept {
+  return asio_buffer_sequence(std::move(seq));
+}
+
+/**
+ * @brief Create an @c asio_buffer_sequence for an async write of one @c const_shared_buffer,
+ * keeping it alive for the duration of the operation.
+ */
+inline asio_buffer_sequence asio_buffers(const const_shared_buffer& buf) {
+  return asio_buffer_sequence(buf);
+}
+
+/**
+ * @brief Storage for reading with Asio dynamic buffer algorithms (such as @c read_until),
+ * built on a mutable shared buffer.
+ *
+ * The bytes in @c [0, size()) of @c readable are the data read and not yet consumed.
+ * Use @c asio_dynamic_buffer to pass this to an Asio algorithm.
+ *
+ * The underlying buffer grows through @c resize_uninitialized, so new bytes are not
+ * zero filled when the allocator of @c Buf is a @c default_init_allocator. The default
+ * is @c mutable_shared_buffer, so that initial contents can be taken over from (and
+ * passed on as) the usual buffer type; with it new bytes are zero filled, but only when
+ * the high water mark grows.
+ *
+ * @code
+ *   chops::dynamic_shared_buffer<chops::basic_mutable_shared_buffer<
+ *                                  chops::default_init_allocator<std::byte>>> dbuf;
+ * @endcode
+ *
+ * @tparam Buf Mutable buffer type, e.g. @c mutable_shared_buffer or one of the other
+ * @c basic_mutable_shared_buffer instantiations.
+ */
+template <typename Buf = mutable_shared_buffer>
+class dynamic_shared_buffer {
+public:
+  using size_type = std::size_t;
+  using buffer_type = Buf;
+
+private:
+  Buf m_buf; // size is the high water mark, bytes past m_end are not initialized by this class
+  size_type m_beg { 0u };
+  size_type m_end { 0u };
+  size_type m_max;
+
+public:
+
+/**
+ * @brief Construct with an optional maximum size.
+ *
+ * @param max_sz Maximum number of readable bytes; @c prepare throws a
+ * @c std::length_error if it is exceeded.
+ */
+  explicit dynamic_shared_buffer(size_type max_sz = std::numeric_limits<size_type>::max()) noexcept :
+      m_buf(), m_max(max_sz) { }
+
+/**
+ * @brief Construct with initial contents, taking over the buffer.
+ */
+  template <std::same_as<Buf> B>
+  explicit dynamic_shared_buffer(B&& buf,
+                                 size_type max_sz = std::numeric_limits<size_type>::max()) noexcept :
+      m_buf(std::move(buf)), m_end(m_buf.size()), m_max(max_sz) { }
+
+/**
+ * @brief Return the number of readable bytes.
+ */
+  size_type size() const noexcept { return m_end - m_beg; }
+
+  size_type max_size() const noexcept { return m_max; }
+
+/**
+ * @brief Return the number of readable bytes that can be held without growing the
+ * underlying buffer.
+ */
+  size_type capacity() const noexcept { return m_buf.capacity() - m_beg; }
+
+/**
+ * @brief Return the readable bytes as a @c std::span.
+ *
+ * The @c std::span is invalidated by @c prepare (or @c grow).
+ */
+  std::span<const std::byte> readable() const noexcept {
+    return { m_buf.data() + m_beg, size() };
+  }
+
+/**
+ * @brief Return a writable region of @c n bytes following the readable bytes.
+ *
+ * The region is not zero filled if the underlying buffer already extends past it. The
+ * readable bytes are moved to the front of the buffer only if that makes the room
+ * needed.
+ *
+ * @throw std::length_error If @c size() + @c n exceeds @c max_size().
+ */
+  std::span<std::byte> prepare(size_type n) {
+    if (n > m_max - size()) {
+      throw std::length_error("dynamic_shared_buffer too long");
+    }
+    if (m_buf.size() - m_end < n) {
+      if (m_beg != 0u && m_buf.size() - size() >= n) {
+        std::memmove(m_buf.data(), m_buf.data() + m_beg, size());
+        m_end -= m_beg;
+        m_beg = 0u;
+      }
+      else {
+        m_buf.resize_uninitialized(m_end + n);
+      }
+    }
+    return { m_buf.data() + m_end, n };
+  }
+
+/**
+ * @brief Move bytes from the front of the writable region to the end of the readable
+ * bytes.
+ *
+ * @pre @c n must not exceed the size of the latest @c prepare region.
+ */
+  void commit(size_type n) noexcept { m_end += n; }
+
+/**
+ * @brief Remove bytes from the end of the readable bytes (they become writable again).
+ */
+  void shrink(size_type n) noexcept { m_end -= (std::min)(n, size()); }
+
+/**
+ * @brief Remove bytes from the front of the readable bytes, without moving any bytes.
+ */
+  void consume(size_type n) noexcept {
+    m_beg += (std::min)(n, size());
+    if (m_beg == m_end) {
+      m_beg = 0u;
+      m_end = 0u;
+    }
+  }
+
+/**
+ * @brief Remove all readable bytes, keeping the underlying buffer for reuse.
+ */
+  void clear() noexcept { m_beg = 0u; m_end = 0u; }
+
+private:
+  template <typename B>
+  friend class dynamic_shared_buffer_ref;
+
+  std::byte* raw_data() noexcept { return m_buf.data(); }
+  const std::byte* raw_data() const noexcept { return m_buf.data(); }
+  size_type read_offset() const noexcept { return m_beg; }
+
+};
+
+/**
+ * @brief A reference to a @c dynamic_shared_buffer, meeting both the DynamicBuffer_v1 and
+ * DynamicBuffer_v2 requirements of Asio.
+ *
+ * Like the Asio @c dynamic_vector_buffer, this is a lightweight copyable object and all
+ * state is kept in the referenced @c dynamic_shared_buffer, which must outlive any
+ * operation using it.
+ */
+template <typename Buf>
+class dynamic_shared_buffer_ref {
+public:
+  using size_type = std::size_t;
+  using const_buffers_type = detail::asio_ns::const_buffer;
+  using mutable_buffers_type = detail::asio_ns::mutable_buffer;
+
+private:
+  dynamic_shared_buffer<Buf>* m_dbuf;
+
+public:
+  explicit dynamic_shared_buffer_ref(dynamic_shared_buffer<Buf>& dbuf) noexcept : m_dbuf(&dbuf) { }
+
+  size_type size() const noexcept { return m_dbuf->size(); }
+  size_type max_size() const noexcept { return m_dbuf->max_size(); }
+  size_type capacity() const noexcept { return m_dbuf->capacity(); }
+
+  // DynamicBuffer_v1
+
+  const_buffers_type data() const noexcept { return asio_buffer(m_dbuf->readable()); }
+
+  mutable_buffers_type prepare(size_type n) {
+    auto sp { m_dbuf->prepare(n) };
+    return { sp.data(), sp.size() };
+  }
+
+  void commit(size_type n) noexcept { m_dbuf->commit(n); }
+
+  // DynamicBuffer_v2
+
+  mutable_buffers_type data(size_type pos, size_type n) noexcept {
+    return detail::asio_ns::buffer(
+             detail::asio_ns::mutable_buffer(m_dbuf->raw_data() + m_dbuf->read_offset(), size()) + pos, n);
+  }
+
+  const_buffers_type data(size_type pos, size_type n) const noexcept {
+    return detail::asio_ns::buffer(
+             detail::asio_ns::const_buffer(m_dbuf->raw_data() + m_dbuf->read_offset(), size()) + pos, n);
+  }
+
+  void grow(size_type n) {
+    m_dbuf->prepare(n);
+    m_dbuf->commit(n);
+  }
+
+  void shrink(size_type n) noexcept { m_dbuf->shrink(n); }
+
+  // common
+
+  void consume(size_type n) noexcept { m_dbuf->consume(n); }
+
+};
+
+/**
+ * @brief Create a dynamic buffer object for Asio algorithms such as @c read_until and
+ * @c async_read_until.
+ */
+template <typename Buf>
+dynamic_shared_buffer_ref<Buf> asio_dynamic_buffer(dynamic_shared_buffer<Buf>& dbuf) noexcept {
+  return dynamic_shared_buffer_ref<Buf>(dbuf);
+}
+
+} // end namespace
+
+#endif
+
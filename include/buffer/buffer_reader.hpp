@@ -0,0 +1,173 @@
+/** @file
+ *
+ * @brief A cursor for reading arithmetic values and byte ranges, in a specific byte
+ * order, from a @c const_shared_buffer (or any contiguous bytes).
+ *
+ * This is the counterpart of the @c append_be, @c append_le, and @c append_val methods
+ * of @c mutable_shared_buffer. Values are read with a @c std::memcpy and a byte swap
+ * when needed, without any pointer arithmetic in application code:
+ *
+ * @code
+ *   chops::buffer_reader rdr(buf);
+ *   auto len = rdr.read_be<std::uint16_t>();
+ *   auto seq = rdr.read_be<std::uint32_t>();
+ *   auto body = rdr.read_bytes(len);
+ * @endcode
+ *
+ * There is no bounds checking on individual reads, the remaining size is checked
+ * once by the caller (e.g. against a message header) using @c remaining.
+ *
+ * @note A @c buffer_reader refers to the bytes without owning them (the same as
+ * @c std::span), so the buffer must outlive the reader.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef BUFFER_READER_HPP_INCLUDED
+#define BUFFER_READER_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <span>
+#include <bit> // std::endian
+#include <concepts> // std::convertible_to
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+/**
+ * @brief Cursor reading values sequentially from a contiguous range of bytes.
+ */
+class buffer_reader {
+public:
+  using size_type = std::size_t;
+
+private:
+  const std::byte* m_beg;
+  const std::byte* m_cur;
+  const std::byte* m_end;
+
+public:
+
+/**
+ * @brief Construct a @c buffer_reader positioned at the beginning of a @c std::span.
+ *
+ * @param sp Bytes to read.
+ */
+  explicit buffer_reader(std::span<const std::byte> sp) noexcept :
+      m_beg(sp.data()), m_cur(sp.data()), m_end(sp.data() + sp.size()) { }
+
+/**
+ * @brief Construct a @c buffer_reader positioned at the beginning of a buffer, such as
+ * a @c const_shared_buffer or @c mutable_shared_buffer.
+ *
+ * @param buf Buffer with @c data and @c size methods.
+ */
+  template <typename Buf>
+    requires requires (const Buf& b) {
+      { b.data() } -> std::convertible_to<const std::byte*>;
+      { b.size() } -> std::convertible_to<size_type>;
+    }
+  explicit buffer_reader(const Buf& buf) noexcept :
+      buffer_reader(std::span<const std::byte>(buf.data(), buf.size())) { }
+
+/**
+ * @brief Read an arithmetic value in big endian (network) byte order, advancing the
+ * cursor.
+ *
+ * @pre @c remaining() must be at least @c sizeof(T).
+ *
+ * @return Value read.
+ */
+  template <detail::endian_value T>
+  T read_be() noexcept {
+    return read<std::endian::big, T>();
+  }
+
+/**
+ * @brief Read an arithmetic value in little endian byte order, advancing the cursor.
+ *
+ * @pre @c remaining() must be at least @c sizeof(T).
+ *
+ * @return Value read.
+ */
+  template <detail::endian_value T>
+  T read_le() noexcept {
+    return read<std::endian::little, T>();
+  }
+
+/**
+ * @brief Read an arithmetic value in network byte order, the same as @c read_be.
+ */
+  template <detail::endian_value T>
+  T read_val() noexcept {
+    return read<std::endian::big, T>();
+  }
+
+/**
+ * @brief Return a @c std::span of the next bytes, advancing the cursor past them.
+ *
+ * @pre @c remaining() must be at least @c n.
+ *
+ * @param n Number of bytes.
+ */
+  std::span<const std::byte> read_bytes(size_type n) noexcept {
+    std::span<const std::byte> sp { m_cur, n };
+    m_cur += n;
+    return sp;
+  }
+
+/**
+ * @brief Advance the cursor without reading.
+ *
+ * @pre @c remaining() must be at least @c n.
+ *
+ * @param n Number of bytes to skip.
+ */
+  void skip(size_type n) noexcept { m_cur += n; }
+
+/**
+ * @brief Return the number of bytes not yet read.
+ */
+  size_type remaining() const noexcept { return static_cast<size_type>(m_end - m_cur); }
+
+/**
+ * @brief Return a @c std::span of the bytes not yet read, without advancing the cursor.
+ */
+  std::span<const std::byte> remaining_bytes() const noexcept { return { m_cur, remaining() }; }
+
+/**
+ * @brief Query to see if all bytes have been read.
+ */
+  bool empty() const noexcept { return m_cur == m_end; }
+
+/**
+ * @brief Return the cursor position, the number of bytes read (or skipped) so far.
+ */
+  size_type position() const noexcept { return static_cast<size_type>(m_cur - m_beg); }
+
+/**
+ * @brief Move the cursor back to the beginning.
+ */
+  void reset() noexcept { m_cur = m_beg; }
+
+private:
+  template <std::endian E, typename T>
+  T read() noexcept {
+    auto val { detail::load_endian<E, T>(m_cur) };
+    m_cur += sizeof(T);
+    return val;
+  }
+
+};
+
+} // end namespace
+
+#endif
+
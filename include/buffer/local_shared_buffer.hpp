@@ -0,0 +1,590 @@
+/** @file
+ *
+ * @brief Shared buffer types with a non-atomic reference count, for buffers that never
+ * cross threads.
+ *
+ * A common design runs one event loop (e.g. an Asio @c io_context) per core, with each
+ * buffer created, written, and destroyed on the same thread. The atomic increment and
+ * decrement performed by @c std::shared_ptr on every copy is wasted work in this design.
+ *
+ * The @c local_mutable_shared_buffer type is a @c basic_mutable_shared_buffer using the
+ * @c local_ref_count policy, and @c local_const_shared_buffer is the non-atomic
+ * counterpart of @c const_shared_buffer. Both have the same interfaces as the thread-safe
+ * types, and a @c local_const_shared_buffer can be efficiently constructed (no buffer
+ * copies) from a @c local_mutable_shared_buffer.
+ *
+ * For the (rare) buffers that do need to cross threads, the @c to_shared functions
+ * convert to the thread-safe types. If no other object shares the bytes, ownership is
+ * transferred without copying, otherwise the bytes are copied.
+ *
+ * @note Objects of these types, along with all copies and slices, must only be used
+ * from one thread at a time. There is no checking of this at runtime.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef LOCAL_SHARED_BUFFER_HPP_INCLUDED
+#define LOCAL_SHARED_BUFFER_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <vector>
+#include <memory> // std::allocator, std::allocator_traits, std::shared_ptr
+#include <memory_resource> // std::pmr::polymorphic_allocator
+#include <compare> // spaceship operator
+#include <span>
+#include <new> // operator new, placement new
+#include <type_traits> // std::conditional_t
+
+#include <utility> // std::move, std::exchange, std::swap
+#include <algorithm> // std::copy, std::transform
+#include <iterator> // std::forward_iterator, std::distance
+#include <concepts> // std::same_as, std::convertible_to
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+namespace detail {
+
+// header of every non-atomically reference counted block
+struct local_block {
+  long refs;
+  void (*destroy)(local_block*) noexcept;
+};
+
+// owning handle to a local_block, of any type
+class local_owner {
+private:
+  local_block* m_blk;
+
+public:
+  local_owner() noexcept : m_blk(nullptr) { }
+  explicit local_owner(local_block* blk) noexcept : m_blk(blk) { }
+
+  local_owner(const local_owner& rhs) noexcept : m_blk(rhs.m_blk) {
+    if (m_blk) {
+      ++m_blk->refs;
+    }
+  }
+  local_owner(local_owner&& rhs) noexcept : m_blk(std::exchange(rhs.m_blk, nullptr)) { }
+
+  local_owner& operator=(local_owner rhs) noexcept {
+    swap(rhs);
+    return *this;
+  }
+
+  ~local_owner() { reset(); }
+
+  void reset() noexcept {
+    auto blk = std::exchange(m_blk, nullptr);
+    if (blk && --blk->refs == 0) {
+      blk->destroy(blk);
+    }
+  }
+
+  void swap(local_owner& rhs) noexcept { std::swap(m_blk, rhs.m_blk); }
+
+  long use_count() const noexcept { return m_blk ? m_blk->refs : 0; }
+};
+
+// owning pointer to an object of type T, the subset of std::shared_ptr needed by
+// basic_mutable_shared_buffer
+template <typename T>
+class local_ptr {
+private:
+  local_owner m_owner;
+  T* m_ptr;
+
+public:
+  local_ptr() noexcept : m_owner(), m_ptr(nullptr) { }
+  local_ptr(local_owner&& owner, T* ptr) noexcept : m_owner(std::move(owner)), m_ptr(ptr) { }
+
+  local_ptr(const local_ptr&) = default;
+  local_ptr(local_ptr&& rhs) noexcept :
+      m_owner(std::move(rhs.m_owner)), m_ptr(std::exchange(rhs.m_ptr, nullptr)) { }
+
+  // from a pointer to a derived type, as std::shared_ptr allows
+  template <typename U>
+    requires std::convertible_to<U*, T*>
+  local_ptr(local_ptr<U>&& rhs) noexcept : m_owner(), m_ptr(rhs.get()) {
+    m_owner = rhs.release_owner();
+  }
+
+  local_ptr& operator=(local_ptr rhs) noexcept {
+    swap(rhs);
+    return *this;
+  }
+
+  T& operator*() const noexcept { return *m_ptr; }
+  T* operator->() const noexcept { return m_ptr; }
+  T* get() const noexcept { return m_ptr; }
+  explicit operator bool() const noexcept { return m_ptr != nullptr; }
+
+  long use_count() const noexcept { return m_owner.use_count(); }
+
+  void reset() noexcept {
+    m_owner.reset();
+    m_ptr = nullptr;
+  }
+
+  void swap(local_ptr& rhs) noexcept {
+    m_owner.swap(rhs.m_owner);
+    std::swap(m_ptr, rhs.m_ptr);
+  }
+
+  friend void swap(local_ptr& lhs, local_ptr& rhs) noexcept { lhs.swap(rhs); }
+
+  // give up ownership, keeping the pointed to object alive through the returned owner
+  local_owner release_owner() noexcept {
+    m_ptr = nullptr;
+    return std::move(m_owner);
+  }
+};
+
+// an object allocated along with its reference count, remembering the allocator
+template <typename T, typename Alloc>
+struct local_node : local_block {
+  using alloc_type = typename std::allocator_traits<Alloc>::template rebind_alloc<local_node>;
+  using traits = std::allocator_traits<alloc_type>;
+
+  [[no_unique_address]] alloc_type alloc;
+  T value;
+
+  template <typename... Args>
+  explicit local_node(const alloc_type& a, Args&&... args) :
+      local_block{1, &destroy_node}, alloc(a), value(std::forward<Args>(args)...) { }
+
+  static void destroy_node(local_block* blk) noexcept {
+    auto node = static_cast<local_node*>(blk);
+    alloc_type a(node->alloc);
+    node->~local_node();
+    traits::deallocate(a, node, 1u);
+  }
+};
+
+template <typename T, typename Alloc, typename... Args>
+local_ptr<T> make_local(const Alloc& alloc, Args&&... args) {
+  using node_type = local_node<T, Alloc>;
+  typename node_type::alloc_type a(alloc);
+  auto node = node_type::traits::allocate(a, 1u);
+  try {
+    ::new (static_cast<void*>(node)) node_type(a, std::forward<Args>(args)...);
+  }
+  catch (...) {
+    node_type::traits::deallocate(a, node, 1u);
+    throw;
+  }
+  return local_ptr<T>(local_owner(node), &node->value);
+}
+
+// the reference count and the bytes in one block, the bytes follow the header
+struct local_bytes : local_block {
+  std::size_t size;
+
+  std::byte* bytes() noexcept { return reinterpret_cast<std::byte*>(this + 1); }
+
+  static void destroy_bytes(local_block* blk) noexcept {
+    auto lb = static_cast<local_bytes*>(blk);
+    stats_block_destroyed(lb->size);
+    ::operator delete(static_cast<void*>(lb), sizeof(local_bytes) + lb->size);
+  }
+};
+
+inline local_ptr<std::byte> make_local_bytes(std::size_t sz) {
+  auto lb = ::new (::operator new(sizeof(local_bytes) + sz))
+                 local_bytes { { 1, &local_bytes::destroy_bytes }, sz };
+  stats_block_created(sz);
+  return local_ptr<std::byte>(local_owner(lb), lb->bytes());
+}
+
+} // end detail namespace
+
+/**
+ * @brief Reference count policy using a non-atomic reference count, for buffers that
+ * are only used from one thread.
+ *
+ * See @c atomic_ref_count for the policy requirements.
+ */
+struct local_ref_count {
+  template <typename T>
+  using pointer = detail::local_ptr<T>;
+
+  template <typename T, typename Alloc, typename... Args>
+  static pointer<T> make(const Alloc& alloc, Args&&... args) {
+    return detail::make_local<T>(alloc, std::forward<Args>(args)...);
+  }
+};
+
+namespace detail {
+
+// reference count policies using local_ptr, which a local_const_shared_buffer can share
+template <typename RefCount>
+concept local_ptr_ref_count = 
+    std::same_as<typename RefCount::template pointer<std::byte>, local_ptr<std::byte>>;
+
+} // end detail namespace
+
+/**
+ * @brief The @c mutable_shared_buffer type with a non-atomic reference count, using
+ * @c std::allocator.
+ */
+using local_mutable_shared_buffer =
+    basic_mutable_shared_buffer<std::allocator<std::byte>, vector_growth, local_ref_count>;
+
+namespace pmr {
+
+/**
+ * @brief A @c local_mutable_shared_buffer using @c std::pmr::polymorphic_allocator.
+ */
+using local_mutable_shared_buffer =
+    basic_mutable_shared_buffer<std::pmr::polymorphic_allocator<std::byte>, vector_growth, local_ref_count>;
+
+}
+
+/**
+ * @brief A reference counted non-modifiable buffer class, the same as
+ * @c const_shared_buffer except that the reference count is not atomic.
+ *
+ * See @c const_shared_buffer for details. Bytes that are copied in are stored in one
+ * block along with the reference count, allocated with global @c operator @c new.
+ *
+ * @invariant There will always be an internal buffer of data, even if the size is zero.
+ *
+ */
+class local_const_shared_buffer {
+public:
+  using byte_vec = std::vector<std::byte>;
+  using size_type = typename byte_vec::size_type;
+
+  static constexpr size_type inline_size = const_shared_buffer::inline_size;
+
+private:
+  detail::local_owner m_owner;
+  const std::byte* m_ptr;
+  size_type m_size;
+
+private:
+
+  local_const_shared_buffer(detail::local_owner&& owner, const std::byte* ptr, size_type sz) noexcept :
+      m_owner(std::move(owner)), m_ptr(ptr), m_size(sz) { }
+
+  template <typename T>
+  explicit local_const_shared_buffer(detail::local_ptr<T>&& lp, const std::byte* ptr, size_type sz) noexcept :
+      m_owner(lp.release_owner()), m_ptr(ptr), m_size(sz) { }
+
+  static local_const_shared_buffer copy_bytes(const std::byte* buf, size_type sz) {
+    auto blk { detail::make_local_bytes(sz) };
+    std::copy(buf, buf+sz, blk.get());
+    auto ptr { blk.get() };
+    return local_const_shared_buffer(std::move(blk), ptr, sz);
+  }
+
+  template <typename InIt>
+  static local_const_shared_buffer copy_range(InIt beg, InIt end) {
+    if constexpr (std::contiguous_iterator<InIt>) {
+      auto sp { detail::contiguous_bytes(beg, end) };
+      return copy_bytes(sp.data(), sp.size());
+    }
+    else if constexpr (std::forward_iterator<InIt>) {
+      auto sz { static_cast<size_type>(std::distance(beg, end)) };
+      auto blk { detail::make_local_bytes(sz) };
+      std::transform(beg, end, blk.get(), [] (const auto& b) { return static_cast<std::byte>(b); } );
+      auto ptr { blk.get() };
+      return local_const_shared_buffer(std::move(blk), ptr, sz);
+    }
+    else {
+      return from_byte_vec<false>(byte_vec(beg, end));
+    }
+  }
+
+  // see the const_shared_buffer from_byte_vec for the counting of the storage
+  template <bool Adopt, typename A>
+  static local_const_shared_buffer from_byte_vec(std::vector<std::byte, A>&& bv) {
+    using vec_type = std::vector<std::byte, A>;
+    vec_type tmp(std::move(bv)); // moved from state is empty either way
+    if (detail::copy_inline<A>(tmp.size())) {
+      return copy_bytes(tmp.data(), tmp.size());
+    }
+    using storage_type = std::conditional_t<Adopt, detail::adopted_storage_vec<vec_type>, 
+                                                   detail::storage_vec<vec_type>>;
+    auto sz { tmp.size() };
+    auto vp { detail::make_local<storage_type>(tmp.get_allocator(), std::move(tmp)) };
+    auto ptr { vp->data() };
+    if constexpr (Adopt) {
+      detail::stats_move(sz);
+    }
+    return local_const_shared_buffer(std::move(vp), ptr, sz);
+  }
+
+public:
+
+  local_const_shared_buffer() = delete;
+
+  // default copy and move construction, should do the right thing
+  local_const_shared_buffer(const local_const_shared_buffer&) = default;
+  local_const_shared_buffer(local_const_shared_buffer&&) = default;
+  // copy and move assignment disabled
+  local_const_shared_buffer& operator=(const local_const_shared_buffer&) = delete;
+  local_const_shared_buffer& operator=(local_const_shared_buffer&&) = delete;
+
+/**
+ * @brief Construct by copying from a @c std::span of @c std::byte.
+ *
+ * @param sp @c std::byte span pointing to buffer of data. The data is
+ * copied into the internal buffer of the @c local_const_shared_buffer.
+ */
+  template <std::size_t Ext>
+  explicit local_const_shared_buffer(std::span<const std::byte, Ext> sp) :
+      local_const_shared_buffer(copy_bytes(sp.data(), sp.size())) { }
+
+/**
+ * @brief Construct by copying from a @c std::byte array.
+ *
+ * @pre Size cannot be greater than the source buffer.
+ *
+ * @param buf Non-null pointer to @c std::byte buffer of data.
+ *
+ * @param sz Size of buffer.
+ */
+  local_const_shared_buffer(const std::byte* buf, std::size_t sz) :
+      local_const_shared_buffer(copy_bytes(buf, sz)) { }
+
+/**
+ * @brief Construct by copying from a @c std::span.
+ *
+ * The element type of the span must be trivially copyable, and not a pointer.
+ *
+ * @param sp @c std::span pointing to buffer of data.
+ */
+  template <detail::byte_copyable T, std::size_t Ext>
+  local_const_shared_buffer(std::span<const T, Ext> sp) :
+      local_const_shared_buffer(std::as_bytes(sp)) { }
+
+/**
+ * @brief Construct by copying the bytes of a contiguous range, such as a @c std::vector,
+ * @c std::array, or @c std::string, with a single copy.
+ *
+ * @param r Contiguous range of trivially copyable (non pointer) elements.
+ */
+  template <detail::contiguous_byte_range R>
+  explicit local_const_shared_buffer(const R& r) :
+      local_const_shared_buffer(detail::range_bytes(r)) { }
+
+/**
+ * @brief Construct by copying bytes from an arbitrary pointer.
+ *
+ * @pre Size cannot be greater than the source buffer.
+ *
+ * @param buf Non-null pointer to a buffer of data.
+ *
+ * @param sz Size of buffer, in bytes.
+ */
+  template <detail::byte_copyable T>
+  local_const_shared_buffer(const T* buf, std::size_t sz) :
+      local_const_shared_buffer(std::as_bytes(std::span<const T>{buf, sz})) { }
+
+/**
+ * @brief Construct by copying from a @c local_mutable_shared_buffer object.
+ *
+ * @param rhs @c local_mutable_shared_buffer containing bytes to be copied.
+ */
+  template <typename A, typename G, detail::local_ptr_ref_count R>
+  explicit local_const_shared_buffer(const basic_mutable_shared_buffer<A, G, R>& rhs) :
+      local_const_shared_buffer(copy_bytes(rhs.data(), rhs.size())) {
+    detail::stats_copy(m_size);
+  }
+
+/**
+ * @brief Construct by moving from a @c local_mutable_shared_buffer object.
+ *
+ * The same as the corresponding @c const_shared_buffer constructor: no bytes are copied
+ * unless other objects share the internal buffer, or the size is not greater than
+ * @c inline_size.
+ *
+ * @param rhs @c local_mutable_shared_buffer to be moved from; after moving the
+ * @c local_mutable_shared_buffer will be empty.
+ */
+  template <typename A, typename G, detail::local_ptr_ref_count R>
+  explicit local_const_shared_buffer(basic_mutable_shared_buffer<A, G, R>&& rhs) :
+      m_owner(), m_ptr(nullptr), m_size(rhs.size()) {
+    const bool small { detail::copy_inline<A>(m_size) };
+    if (small || rhs.m_data.use_count() != 1) {
+      const auto& src { rhs }; // const access, never clones a copy on write buffer
+      auto cp { copy_bytes(src.data(), src.size()) };
+      detail::stats_copy(m_size);
+      m_owner = std::move(cp.m_owner);
+      m_ptr = cp.m_ptr;
+      if (small && rhs.m_data.use_count() == 1) {
+        rhs.clear();
+        return;
+      }
+    }
+    else {
+      m_ptr = rhs.m_data->data();
+      m_owner = rhs.m_data.release_owner();
+      detail::stats_move(m_size);
+    }
+    rhs.m_data.reset();
+  }
+
+/**
+ * @brief Move construct from a @c std::vector of @c std::bytes.
+ *
+ * If the size is not greater than @c inline_size, the bytes are copied into a single
+ * block along with the reference count.
+ */
+  template <typename A>
+  explicit local_const_shared_buffer(std::vector<std::byte, A>&& bv) :
+      local_const_shared_buffer(from_byte_vec<true>(std::move(bv))) { }
+
+/**
+ * @brief Construct from input iterators.
+ *
+ * Contiguous iterators of one byte elements are copied with a single memcpy, other
+ * iterators must have a value type of @c std::byte.
+ *
+ * @pre Valid iterator range.
+ *
+ * @param beg Beginning input iterator of range.
+ * @param end Ending input iterator of range.
+ */
+  template <detail::byte_iterator InIt>
+  local_const_shared_buffer(InIt beg, InIt end) : local_const_shared_buffer(copy_range(beg, end)) { }
+
+/**
+ * @brief Return @c const @c std::byte pointer to beginning of buffer.
+ */
+  const std::byte* data() const noexcept { return m_ptr; }
+
+/**
+ * @brief Return size (number of bytes) of buffer.
+ */
+  size_type size() const noexcept { return m_size; }
+
+/**
+ * @brief Query to see if size is zero.
+ */
+  bool empty() const noexcept { return m_size == 0u; }
+
+/**
+ * @brief Return a @c local_const_shared_buffer that refers to a sub-range of this
+ * buffer, without copying any bytes.
+ *
+ * @pre @c offset @c + @c length cannot be greater than @c size().
+ */
+  local_const_shared_buffer slice(size_type offset, size_type length) const noexcept {
+    return local_const_shared_buffer(detail::local_owner(m_owner), m_ptr + offset, length);
+  }
+
+/**
+ * @brief Return a @c local_const_shared_buffer that refers to the bytes from an offset
+ * to the end of this buffer, without copying any bytes.
+ *
+ * @pre @c offset cannot be greater than @c size().
+ */
+  local_const_shared_buffer slice(size_type offset) const noexcept {
+    return slice(offset, size() - offset);
+  }
+
+/**
+ * @brief Compare two @c local_const_shared_buffer objects for internal buffer
+ * byte-by-byte equality.
+ */
+  bool operator== (const local_const_shared_buffer& rhs) const noexcept {
+    return detail::equal_bytes(data(), size(), rhs.data(), rhs.size());
+  }
+
+/**
+ * @brief Compare two @c local_const_shared_buffer objects for internal buffer
+ * byte-by-byte spaceship operator ordering.
+ */
+  auto operator<=> (const local_const_shared_buffer& rhs) const noexcept {
+    return detail::compare_bytes(data(), size(), rhs.data(), rhs.size());
+  }
+
+private:
+
+  friend const_shared_buffer to_shared(local_const_shared_buffer&& buf);
+
+  const_shared_buffer transfer_to_shared() {
+    // the deleter holds a second reference until the std::shared_ptr is fully
+    // constructed, so a failed allocation leaves this object intact
+    std::shared_ptr<const std::byte> sp(m_ptr,
+        [owner = m_owner] (const std::byte*) mutable { owner.reset(); } );
+    m_owner.reset();
+    return const_shared_buffer(std::move(sp), m_size);
+  }
+
+}; // end local_const_shared_buffer class
+
+// non-member functions
+
+/**
+ * @brief Convert to a (thread-safe) @c const_shared_buffer by copying the bytes.
+ */
+inline const_shared_buffer to_shared(const local_const_shared_buffer& buf) {
+  detail::stats_copy(buf.size());
+  return const_shared_buffer(buf.data(), buf.size());
+}
+
+/**
+ * @brief Convert to a (thread-safe) @c const_shared_buffer, transferring ownership of
+ * the bytes when possible.
+ *
+ * If no other object (copy or slice) shares the bytes, the @c const_shared_buffer takes
+ * over ownership without copying. Otherwise the bytes are copied, since the non-atomic
+ * reference count cannot be shared with another thread.
+ *
+ * @param buf @c local_const_shared_buffer to be moved from.
+ */
+inline const_shared_buffer to_shared(local_const_shared_buffer&& buf) {
+  if (buf.m_owner.use_count() != 1) {
+    return to_shared(buf);
+  }
+  detail::stats_move(buf.size());
+  return buf.transfer_to_shared();
+}
+
+/**
+ * @brief Convert to a (thread-safe) @c mutable_shared_buffer by copying the bytes.
+ */
+template <typename A, typename G>
+basic_mutable_shared_buffer<A, G> to_shared(const basic_mutable_shared_buffer<A, G, local_ref_count>& buf) {
+  detail::stats_copy(buf.size());
+  return basic_mutable_shared_buffer<A, G>(buf.data(), buf.size(), buf.get_allocator());
+}
+
+/**
+ * @brief Convert to a (thread-safe) @c mutable_shared_buffer, moving the bytes when
+ * possible.
+ *
+ * If no other @c local_mutable_shared_buffer shares the internal buffer, the
+ * @c std::vector is moved without copying the bytes, leaving @c buf empty. Otherwise
+ * the bytes are copied.
+ *
+ * @param buf @c local_mutable_shared_buffer to be moved from.
+ */
+template <typename A, typename G>
+basic_mutable_shared_buffer<A, G> to_shared(basic_mutable_shared_buffer<A, G, local_ref_count>&& buf) {
+  if (buf.use_count() == 0) { // no internal buffer yet
+    return basic_mutable_shared_buffer<A, G>(buf.get_allocator());
+  }
+  if (buf.use_count() != 1) {
+    return to_shared(buf);
+  }
+  auto& vec { buf.get_byte_vec() };
+  basic_mutable_shared_buffer<A, G> res(std::move(vec)); // counted as a zero copy move
+  detail::stats_sync(vec); // the moved from vector no longer holds the bytes
+  return res;
+}
+
+} // end namespace
+
+#endif
+
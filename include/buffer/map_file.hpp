@@ -0,0 +1,175 @@
+/** @file
+ *
+ * @brief Create a @c const_shared_buffer backed by a read-only memory mapped file.
+ *
+ * Large static files (snapshots, replay files) can be sent over the network without
+ * reading them into memory first. The file is mapped read-only, and the mapping has
+ * the same reference counted lifetime as any other @c const_shared_buffer: the file is
+ * unmapped when the last @c const_shared_buffer (including copies and slices) goes away.
+ * Pages are read in by the operating system on demand, and are shared with the file
+ * cache instead of being copied into process memory.
+ *
+ * POSIX (@c mmap) and Windows (@c MapViewOfFile) are supported. Failures are reported
+ * by throwing @c std::system_error with the operating system error code.
+ *
+ * @note The file contents must not be modified (e.g. by another process) while the
+ * mapping is in use, since a @c const_shared_buffer is assumed to never change.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef MAP_FILE_HPP_INCLUDED
+#define MAP_FILE_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <cstdint> // std::uint64_t
+#include <filesystem>
+#include <system_error>
+#include <limits>
+#include <span>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#include <cerrno>
+#endif
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+namespace detail {
+
+#if defined(_WIN32)
+
+// closes a handle when going out of scope
+struct win_handle {
+  HANDLE h;
+  ~win_handle() {
+    if (h != nullptr && h != INVALID_HANDLE_VALUE) {
+      ::CloseHandle(h);
+    }
+  }
+};
+
+[[noreturn]] inline void throw_map_error(const char* what) {
+  throw std::system_error(static_cast<int>(::GetLastError()), std::system_category(), what);
+}
+
+#else
+
+// closes a file descriptor when going out of scope
+struct posix_fd {
+  int fd;
+  ~posix_fd() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+};
+
+[[noreturn]] inline void throw_map_error(const char* what) {
+  throw std::system_error(errno, std::system_category(), what);
+}
+
+#endif
+
+} // end detail namespace
+
+/**
+ * @brief Map a file read-only into memory, returning a @c const_shared_buffer that
+ * refers to the whole file.
+ *
+ * No bytes are copied. The file is unmapped when the last @c const_shared_buffer
+ * referring to it (including slices created with @c const_shared_buffer::slice) is
+ * destroyed. The file handle is closed before returning, the mapping stays valid
+ * without it.
+ *
+ * An empty file results in an empty @c const_shared_buffer, since a zero length
+ * mapping cannot be created.
+ *
+ * @param path Path of the file to map.
+ *
+ * @return @c const_shared_buffer referring to the mapped bytes.
+ *
+ * @throw std::system_error If the file cannot be opened, its size cannot be determined,
+ * or the mapping fails.
+ */
+inline const_shared_buffer map_file(const std::filesystem::path& path) {
+
+#if defined(_WIN32)
+
+  detail::win_handle file { ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+  if (file.h == INVALID_HANDLE_VALUE) {
+    detail::throw_map_error("map_file: CreateFileW");
+  }
+  LARGE_INTEGER fsz;
+  if (!::GetFileSizeEx(file.h, &fsz)) {
+    detail::throw_map_error("map_file: GetFileSizeEx");
+  }
+  auto sz { static_cast<std::uint64_t>(fsz.QuadPart) };
+  if (sz == 0u) {
+    return const_shared_buffer(std::span<const std::byte>());
+  }
+  if (sz > std::numeric_limits<std::size_t>::max()) {
+    throw std::system_error(std::make_error_code(std::errc::file_too_large), "map_file");
+  }
+  detail::win_handle mapping { ::CreateFileMappingW(file.h, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+  if (mapping.h == nullptr) {
+    detail::throw_map_error("map_file: CreateFileMappingW");
+  }
+  auto addr = ::MapViewOfFile(mapping.h, FILE_MAP_READ, 0, 0, 0);
+  if (addr == nullptr) {
+    detail::throw_map_error("map_file: MapViewOfFile");
+  }
+  return const_shared_buffer(addr, static_cast<std::size_t>(sz), 
+                             [] (void* p) { ::UnmapViewOfFile(p); } );
+
+#else
+
+  detail::posix_fd file { ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+  if (file.fd < 0) {
+    detail::throw_map_error("map_file: open");
+  }
+  struct ::stat st;
+  if (::fstat(file.fd, &st) != 0) {
+    detail::throw_map_error("map_file: fstat");
+  }
+  if (st.st_size == 0) {
+    return const_shared_buffer(std::span<const std::byte>());
+  }
+  if (static_cast<std::uint64_t>(st.st_size) > std::numeric_limits<std::size_t>::max()) {
+    throw std::system_error(std::make_error_code(std::errc::file_too_large), "map_file");
+  }
+  auto sz { static_cast<std::size_t>(st.st_size) };
+  auto addr = ::mmap(nullptr, sz, PROT_READ, MAP_PRIVATE, file.fd, 0);
+  if (addr == MAP_FAILED) {
+    detail::throw_map_error("map_file: mmap");
+  }
+  return const_shared_buffer(addr, sz, [sz] (void* p) { ::munmap(p, sz); } );
+
+#endif
+
+}
+
+} // end namespace
+
+#endif
+
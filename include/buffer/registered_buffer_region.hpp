@@ -0,0 +1,289 @@
+/** @file
+ *
+ * @brief A memory region divided into fixed size slots, for @c mutable_shared_buffer
+ * storage that is registered once with the kernel, such as @c io_uring fixed buffers.
+ *
+ * With Linux @c io_uring, buffers registered with @c IORING_REGISTER_BUFFERS can be
+ * used with @c IORING_OP_READ_FIXED and @c IORING_OP_WRITE_FIXED, avoiding the cost
+ * of pinning the pages on every IO operation. A @c registered_buffer_region allocates
+ * one large page aligned block of memory, divided into slots. The IO vectors for the
+ * slots are passed to the registration call once, and buffers created from the region
+ * use a slot for their bytes.
+ *
+ * The buffers are @c basic_mutable_shared_buffer objects using the
+ * @c registered_allocator, so the usual lifetime model applies: a buffer, or a
+ * @c const_shared_buffer it was moved into, keeps the slot in use until the last
+ * reference goes away, and then the slot is returned to the region. The
+ * @c buffer_index method returns the registered buffer index (slot) for any pointer
+ * into a slot, as needed in the submission queue entry for fixed buffer IO.
+ *
+ * There is no dependency on @c io_uring (or any platform) headers.
+ *
+ * @note The region must outlive all buffers that have been created from it.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef REGISTERED_BUFFER_REGION_HPP_INCLUDED
+#define REGISTERED_BUFFER_REGION_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <vector>
+#include <memory> // std::allocator
+#include <new> // operator new, std::align_val_t, std::bad_alloc
+#include <mutex>
+#include <optional>
+#include <span>
+#include <type_traits> // std::is_same_v, std::true_type
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+class registered_buffer_region;
+
+/**
+ * @brief Allocator that takes @c std::byte storage from the slots of a
+ * @c registered_buffer_region.
+ *
+ * Only @c std::byte allocations (the @c std::vector storage) use the region; rebound
+ * allocators for other types (such as the reference count block) use @c std::allocator.
+ * A @c std::byte allocation larger than the slot size, or made when all slots are in
+ * use, also uses @c std::allocator, and is not registered.
+ */
+template <typename T>
+class registered_allocator {
+public:
+  using value_type = T;
+
+private:
+  registered_buffer_region* m_region;
+
+public:
+  registered_allocator(registered_buffer_region* region) noexcept : m_region(region) { }
+
+  template <typename U>
+  registered_allocator(const registered_allocator<U>& rhs) noexcept : m_region(rhs.region()) { }
+
+  T* allocate(std::size_t n);
+  void deallocate(T* p, std::size_t n) noexcept;
+
+  registered_buffer_region* region() const noexcept { return m_region; }
+
+  template <typename U>
+  bool operator==(const registered_allocator<U>& rhs) const noexcept { return m_region == rhs.region(); }
+};
+
+/**
+ * @brief The bytes of a buffer using a @c registered_allocator stay in their slot when
+ * moved into a @c const_shared_buffer, however small.
+ */
+template <>
+struct keeps_buffer_storage<registered_allocator<std::byte>> : std::true_type { };
+
+/**
+ * @brief A @c mutable_shared_buffer with storage in a @c registered_buffer_region slot.
+ */
+using registered_mutable_shared_buffer = basic_mutable_shared_buffer<registered_allocator<std::byte>>;
+
+/**
+ * @brief One page aligned block of memory, divided into fixed size slots which are used
+ * for buffer storage.
+ *
+ * Slots can be allocated and released from any thread.
+ */
+class registered_buffer_region {
+public:
+  using size_type = std::size_t;
+
+  static constexpr size_type default_alignment = 4096u;
+
+private:
+  std::byte* m_base;
+  size_type m_slot_size;
+  size_type m_slot_count;
+  size_type m_alignment;
+  mutable std::mutex m_mutex;
+  std::vector<size_type> m_free; // stack of free slot indices
+
+public:
+
+/**
+ * @brief Construct a @c registered_buffer_region, allocating the memory for all slots.
+ *
+ * @param slot_size Size of each slot, which is the largest buffer that stays in
+ * registered memory; rounded up to a multiple of the alignment.
+ *
+ * @param slot_count Number of slots.
+ *
+ * @param alignment Alignment of the region and of each slot, by default a typical page
+ * size.
+ *
+ * @throw std::bad_alloc If the memory cannot be allocated.
+ */
+  registered_buffer_region(size_type slot_size, size_type slot_count,
+                           size_type alignment = default_alignment) :
+      m_base(nullptr),
+      m_slot_size((slot_size + alignment - 1u) / alignment * alignment),
+      m_slot_count(slot_count),
+      m_alignment(alignment),
+      m_mutex(),
+      m_free() {
+    m_free.reserve(m_slot_count);
+    for (size_type i = m_slot_count; i > 0u; --i) {
+      m_free.push_back(i - 1u);
+    }
+    m_base = static_cast<std::byte*>(::operator new(m_slot_size * m_slot_count,
+                                                    std::align_val_t{m_alignment}));
+  }
+
+  registered_buffer_region(const registered_buffer_region&) = delete;
+  registered_buffer_region& operator=(const registered_buffer_region&) = delete;
+
+  ~registered_buffer_region() {
+    ::operator delete(m_base, m_slot_size * m_slot_count, std::align_val_t{m_alignment});
+  }
+
+/**
+ * @brief Create a buffer using a slot for its storage, with bytes set to zero.
+ *
+ * The full slot is reserved, so the buffer can grow up to the slot size (e.g. by
+ * appending) and stay in the slot.
+ *
+ * @param sz Size of the buffer.
+ *
+ * @return @c registered_mutable_shared_buffer; if no slot is free, or the size is
+ * greater than the slot size, the storage is not in the region (which can be checked
+ * with @c buffer_index).
+ */
+  registered_mutable_shared_buffer make_buffer(size_type sz = 0u) {
+    registered_mutable_shared_buffer buf(registered_allocator<std::byte>(this));
+    buf.reserve(sz > m_slot_size ? sz : m_slot_size);
+    buf.resize(sz);
+    return buf;
+  }
+
+/**
+ * @brief Return the registered buffer index (slot) of a pointer into the region.
+ *
+ * @param p Pointer to any byte within a slot, such as the @c data pointer of a
+ * buffer, or of a slice of a @c const_shared_buffer.
+ *
+ * @return Slot index, or an empty @c std::optional if the pointer is not in the
+ * region.
+ */
+  std::optional<size_type> buffer_index(const std::byte* p) const noexcept {
+    if (p == nullptr || p < m_base || p >= m_base + m_slot_size * m_slot_count) {
+      return { };
+    }
+    return static_cast<size_type>(p - m_base) / m_slot_size;
+  }
+
+/**
+ * @brief Fill in IO vector entries for registration, one per slot.
+ *
+ * The IO vector type must have an @c iov_base (pointer) member and an @c iov_len
+ * (length) member, as the POSIX @c iovec structure has. The entry index matches the
+ * slot index returned by @c buffer_index.
+ *
+ * @param iovs Span of IO vector entries to fill in.
+ *
+ * @return Number of entries filled in, the smaller of the span size and the number of
+ * slots.
+ */
+  template <typename IoVec>
+  size_type fill_io_vectors(std::span<IoVec> iovs) const noexcept {
+    size_type cnt { 0u };
+    for (; cnt < iovs.size() && cnt < m_slot_count; ++cnt) {
+      iovs[cnt].iov_base = static_cast<void*>(m_base + cnt * m_slot_size);
+      iovs[cnt].iov_len = m_slot_size;
+    }
+    return cnt;
+  }
+
+/**
+ * @brief Return a pointer to the beginning of the region.
+ */
+  const std::byte* data() const noexcept { return m_base; }
+
+/**
+ * @brief Return the size of each slot.
+ */
+  size_type slot_size() const noexcept { return m_slot_size; }
+
+/**
+ * @brief Return the number of slots.
+ */
+  size_type slot_count() const noexcept { return m_slot_count; }
+
+/**
+ * @brief Return the number of slots not in use.
+ */
+  size_type free_slots() const {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_free.size();
+  }
+
+/**
+ * @brief Allocate storage, from a slot if possible.
+ *
+ * This is called by @c registered_allocator.
+ */
+  std::byte* allocate_bytes(size_type n) {
+    if (n <= m_slot_size) {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (!m_free.empty()) {
+        auto idx = m_free.back();
+        m_free.pop_back();
+        return m_base + idx * m_slot_size;
+      }
+    }
+    return std::allocator<std::byte>().allocate(n);
+  }
+
+/**
+ * @brief Release storage allocated with @c allocate_bytes.
+ *
+ * This is called by @c registered_allocator.
+ */
+  void deallocate_bytes(std::byte* p, size_type n) noexcept {
+    if (auto idx = buffer_index(p)) {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_free.push_back(*idx); // capacity reserved up front, cannot throw
+      return;
+    }
+    std::allocator<std::byte>().deallocate(p, n);
+  }
+
+};
+
+template <typename T>
+T* registered_allocator<T>::allocate(std::size_t n) {
+  if constexpr (std::is_same_v<T, std::byte>) {
+    return m_region->allocate_bytes(n);
+  }
+  else {
+    return std::allocator<T>().allocate(n);
+  }
+}
+
+template <typename T>
+void registered_allocator<T>::deallocate(T* p, std::size_t n) noexcept {
+  if constexpr (std::is_same_v<T, std::byte>) {
+    m_region->deallocate_bytes(p, n);
+  }
+  else {
+    std::allocator<T>().deallocate(p, n);
+  }
+}
+
+} // end namespace
+
+#endif
+
@@ -29,19 +29,39 @@
  * A @c const_shared_buffer can be efficiently constructed (no buffer copies) from a 
  * @c mutable shared_buffer. This allows the use case of serializing data into a 
  * @c mutable_shared_buffer then constructing a @c const_shared_buffer for writing to
- * the network.
+ * the network. Small payloads (heartbeats, acks, control messages) are the exception,
+ * see below.
  *
  * Besides the data buffer lifetime management, these utility classes eliminate data 
  * copies and (obviously) do not have to be used only in networking use cases.
  *
  * ### Additional Details
  *
- * Internally all data is stored in a @c std::vector of @c std::byte. There are 
- * convenience templated constructors so that the @c shared_buffer objects can
- * be constructed from traditional byte buffers, such as @c char @c *.
+ * Internally a @c mutable_shared_buffer stores data in a @c std::vector of 
+ * @c std::byte. A @c const_shared_buffer that copies its bytes stores the reference
+ * count and the bytes in one contiguous allocation, and keeps the data pointer and
+ * size directly in the object, so that @c data and @c size do not need to follow
+ * a pointer into the shared storage. There are convenience templated constructors 
+ * so that the @c shared_buffer objects can be constructed from traditional byte 
+ * buffers, such as @c char @c *.
+ *
+ * Payloads no larger than @c SHARED_BUFFER_INLINE_SIZE bytes (64 by default) that are 
+ * moved into a @c const_shared_buffer are copied into a single block holding both the
+ * reference count and the bytes, instead of keeping the @c std::vector (and its separate
+ * heap allocation) alive. A moved from @c mutable_shared_buffer keeps its capacity in this
+ * case, so serializing a stream of small messages through one @c mutable_shared_buffer
+ * needs one allocation per message. Defining @c SHARED_BUFFER_INLINE_SIZE as 0 before 
+ * including this header disables the copy.
  *
  * There are ordering methods so that shared buffer objects can be stored in 
- * sequential or associative containers.
+ * sequential or associative containers. A @c std::hash specialization allows a
+ * @c const_shared_buffer to be used as a key in unordered containers; the hash value
+ * is computed once and cached in the @c const_shared_buffer object (see @c hash).
+ *
+ * Defining @c SHARED_BUFFER_ENABLE_STATS before including this header turns on 
+ * allocation and lifetime statistics (allocations, reallocations, deep copies versus 
+ * zero copy moves, live and peak bytes, and a size histogram), read through
+ * @c shared_buffer_stats_snapshot. Without the macro the hooks compile to nothing.
  *
  * Efficient moving of data (versus copying) is enabled in multiple ways, including
  * allowing a @c const_shared_buffer to be move constructed from a 
@@ -75,22 +95,849 @@
 #define SHARED_BUFFER_HPP_INCLUDED
 
 #include <cstddef> // std::byte
+#include <cstring> // std::memcmp, std::memcpy
+#include <cstdint> // std::uint64_t
+#include <cassert>
+#include <atomic>
+#include <optional>
+#include <functional> // std::hash
 #include <vector>
-#include <memory> // std::shared_ptr
+#include <memory> // std::shared_ptr, std::allocate_shared, std::to_address
+#include <memory_resource> // std::pmr::polymorphic_allocator
 #include <compare> // spaceship operator
 #include <span>
+#include <array>
+
+#include <utility> // std::move, std::swap, std::exchange
+#include <algorithm> // std::copy, std::transform, std::min, std::max
+#include <iterator> // std::forward_iterator, std::contiguous_iterator, std::distance
+#include <ranges> // std::ranges::forward_range, std::ranges::contiguous_range, std::ranges::range_value_t
+#include <type_traits> // std::is_nothrow_default_constructible_v, std::is_trivially_copyable_v, std::conditional_t
+#include <concepts> // std::invocable, std::integral, std::floating_point
+#include <bit> // std::endian, std::bit_cast, std::bit_width
+#if defined(_MSC_VER)
+#include <cstdlib> // _byteswap_ushort, _byteswap_ulong, _byteswap_uint64
+#endif
+#include <new> // placement new
 
-#include <utility> // std::move, std::swap
-#include <algorithm> // std::copy
-
-// TODO - add concepts and / or requires
-//
-// modify the templated constructor that takes a buffer of any valid 
-// byte type, add constraints which makes the casting safer
+#ifndef SHARED_BUFFER_INLINE_SIZE
+#define SHARED_BUFFER_INLINE_SIZE 64
+#endif
 
 namespace chops {
 
+/**
+ * @brief A snapshot of the allocation and lifetime statistics of the shared buffer
+ * classes.
+ *
+ * Statistics are only collected when @c SHARED_BUFFER_ENABLE_STATS is defined before
+ * this header is included (consistently in every translation unit); otherwise there
+ * is no overhead and every value in a snapshot is zero. The counters are relaxed 
+ * atomics, shared by all threads.
+ *
+ * The storage counted is the storage allocated by the shared buffer classes: the 
+ * internal buffer of a mutable buffer (byte count is the @c std::vector capacity), a 
+ * single block holding the bytes of a const buffer, and a @c std::vector moved into a
+ * const buffer. Memory owned elsewhere (e.g. wrapped through a @c std::shared_ptr 
+ * constructor, or a memory mapped file) is not counted. Changes made to a 
+ * @c std::vector through @c get_byte_vec are counted at the next modification made
+ * through the mutable buffer.
+ */
+struct shared_buffer_stats {
+  static constexpr std::size_t histogram_size = 16u;
+
+  std::uint64_t allocations { 0u }; ///< Storage allocations (the first for each internal buffer).
+  std::uint64_t reallocations { 0u }; ///< Mutable buffer growth past the capacity.
+  std::uint64_t deep_copies { 0u }; ///< Byte copies from one shared buffer into another.
+  std::uint64_t bytes_copied { 0u };
+  std::uint64_t zero_copy_moves { 0u }; ///< Storage handed over without copying bytes.
+  std::uint64_t bytes_moved { 0u };
+  std::uint64_t live_buffers { 0u }; ///< Storage currently allocated.
+  std::uint64_t live_bytes { 0u };
+  std::uint64_t peak_live_bytes { 0u };
+  /// Allocation sizes, entry @c i counts sizes up to 2 to the power of @c i + 4 bytes, 
+  /// with the last entry counting all larger sizes.
+  std::array<std::uint64_t, histogram_size> size_histogram { };
+};
+
+#if defined(SHARED_BUFFER_ENABLE_STATS)
+inline constexpr bool shared_buffer_stats_enabled = true;
+#else
+inline constexpr bool shared_buffer_stats_enabled = false;
+#endif
+
+namespace detail {
+
+#if defined(SHARED_BUFFER_ENABLE_STATS)
+
+struct stats_counters {
+  std::atomic<std::uint64_t> allocations { 0u };
+  std::atomic<std::uint64_t> reallocations { 0u };
+  std::atomic<std::uint64_t> deep_copies { 0u };
+  std::atomic<std::uint64_t> bytes_copied { 0u };
+  std::atomic<std::uint64_t> zero_copy_moves { 0u };
+  std::atomic<std::uint64_t> bytes_moved { 0u };
+  std::atomic<std::uint64_t> live_buffers { 0u };
+  std::atomic<std::uint64_t> live_bytes { 0u };
+  std::atomic<std::uint64_t> peak_live_bytes { 0u };
+  std::array<std::atomic<std::uint64_t>, shared_buffer_stats::histogram_size> size_histogram { };
+};
+
+inline stats_counters stats_data;
+
+inline void stats_inc(std::atomic<std::uint64_t>& ctr, std::uint64_t n = 1u) noexcept {
+  ctr.fetch_add(n, std::memory_order_relaxed);
+}
+
+inline void stats_allocation(std::size_t sz) noexcept {
+  auto wid { static_cast<std::size_t>(std::bit_width(sz > 0u ? sz - 1u : 0u)) };
+  auto idx { wid <= 4u ? 0u : (std::min)(wid - 4u, shared_buffer_stats::histogram_size - 1u) };
+  stats_inc(stats_data.allocations);
+  stats_inc(stats_data.size_histogram[idx]);
+}
+
+inline void stats_live_add(std::size_t sz) noexcept {
+  auto live { stats_data.live_bytes.fetch_add(sz, std::memory_order_relaxed) + sz };
+  auto peak { stats_data.peak_live_bytes.load(std::memory_order_relaxed) };
+  while (live > peak && 
+         !stats_data.peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+}
+
+inline void stats_live_sub(std::size_t sz) noexcept {
+  stats_data.live_bytes.fetch_sub(sz, std::memory_order_relaxed);
+}
+
+inline void stats_block_created(std::size_t sz) noexcept {
+  stats_allocation(sz);
+  stats_inc(stats_data.live_buffers);
+  stats_live_add(sz);
+}
+
+inline void stats_block_destroyed(std::size_t sz) noexcept {
+  stats_data.live_buffers.fetch_sub(1u, std::memory_order_relaxed);
+  stats_live_sub(sz);
+}
+
+inline void stats_copy(std::size_t sz) noexcept {
+  stats_inc(stats_data.deep_copies);
+  stats_inc(stats_data.bytes_copied, sz);
+}
+
+inline void stats_move(std::size_t sz) noexcept {
+  stats_inc(stats_data.zero_copy_moves);
+  stats_inc(stats_data.bytes_moved, sz);
+}
+
+struct adopt_vec_t { };
+
+// a std::vector used as shared storage, keeping the live byte count in step with 
+// its capacity; sync is called after each modification that can change the capacity
+template <typename V>
+struct counted_vec : V {
+  std::size_t counted { 0u };
+
+  explicit counted_vec(V&& v) noexcept : V(std::move(v)) { 
+    stats_inc(stats_data.live_buffers);
+    sync();
+  }
+  // uses-allocator construction, e.g. by std::pmr::polymorphic_allocator
+  counted_vec(V&& v, const typename V::allocator_type& alloc) : V(std::move(v), alloc) { 
+    stats_inc(stats_data.live_buffers);
+    sync();
+  }
+  // an application vector moved in, its storage is live but was not allocated here
+  counted_vec(adopt_vec_t, V&& v) noexcept : V(std::move(v)) { 
+    stats_inc(stats_data.live_buffers);
+    adopt(v);
+  }
+  counted_vec(adopt_vec_t, V&& v, const typename V::allocator_type& alloc) : V(std::move(v), alloc) { 
+    stats_inc(stats_data.live_buffers);
+    adopt(v);
+  }
+  counted_vec(const counted_vec&) = delete;
+  counted_vec& operator=(const counted_vec&) = delete;
+
+  ~counted_vec() {
+    stats_data.live_buffers.fetch_sub(1u, std::memory_order_relaxed);
+    stats_live_sub(counted);
+  }
+
+  void sync() noexcept {
+    auto cap { this->capacity() };
+    if (cap > counted) {
+      if (counted == 0u) {
+        stats_allocation(cap);
+      }
+      else {
+        stats_inc(stats_data.reallocations);
+      }
+      stats_live_add(cap - counted);
+    }
+    else if (cap < counted) {
+      stats_live_sub(counted - cap); // shrink_to_fit, or moved from
+    }
+    counted = cap;
+  }
+
+  void adopt(const V& src) noexcept {
+    if (src.capacity() != 0u) { // copied, with an allocator not equal to the source one
+      sync();
+      return;
+    }
+    counted = this->capacity();
+    stats_live_add(counted);
+  }
+};
+
+template <typename V>
+struct adopted_vec : counted_vec<V> {
+  explicit adopted_vec(V&& v) noexcept : counted_vec<V>(adopt_vec_t { }, std::move(v)) { }
+  adopted_vec(V&& v, const typename V::allocator_type& alloc) : 
+      counted_vec<V>(adopt_vec_t { }, std::move(v), alloc) { }
+};
+
+template <typename V>
+using storage_vec = counted_vec<V>;
+
+// storage taking over a vector passed in by the application
+template <typename V>
+using adopted_storage_vec = adopted_vec<V>;
+
+template <typename V>
+void stats_sync(V& vec) noexcept {
+  static_cast<counted_vec<V>&>(vec).sync();
+}
+
+// allocator adaptor counting a block of shared storage holding a number of bytes
+template <typename A>
+class counted_allocator {
+private:
+  template <typename>
+  friend class counted_allocator;
+
+  using traits = std::allocator_traits<A>;
+
+  A m_alloc;
+  std::size_t m_bytes;
+
+public:
+  using value_type = typename traits::value_type;
+
+  template <typename U>
+  struct rebind {
+    using other = counted_allocator<typename traits::template rebind_alloc<U>>;
+  };
+
+  counted_allocator(const A& alloc, std::size_t bytes) noexcept : m_alloc(alloc), m_bytes(bytes) { }
+
+  template <typename B>
+  counted_allocator(const counted_allocator<B>& rhs) noexcept : 
+      m_alloc(rhs.m_alloc), m_bytes(rhs.m_bytes) { }
+
+  value_type* allocate(std::size_t n) {
+    auto ptr { traits::allocate(m_alloc, n) };
+    stats_block_created(m_bytes);
+    return ptr;
+  }
+
+  void deallocate(value_type* ptr, std::size_t n) noexcept {
+    traits::deallocate(m_alloc, ptr, n);
+    stats_block_destroyed(m_bytes);
+  }
+
+  template <typename B>
+  friend bool operator==(const counted_allocator& lhs, const counted_allocator<B>& rhs) noexcept {
+    return lhs.m_alloc == rhs.m_alloc;
+  }
+};
+
+template <typename A>
+counted_allocator<A> stats_block_alloc(const A& alloc, std::size_t bytes) noexcept {
+  return counted_allocator<A>(alloc, bytes);
+}
+
+#else
+
+template <typename V>
+using storage_vec = V;
+
+template <typename V>
+using adopted_storage_vec = V;
+
+template <typename V>
+constexpr void stats_sync(V&) noexcept { }
+
+template <typename A>
+constexpr const A& stats_block_alloc(const A& alloc, std::size_t) noexcept { return alloc; }
+
+constexpr void stats_block_created(std::size_t) noexcept { }
+constexpr void stats_block_destroyed(std::size_t) noexcept { }
+constexpr void stats_copy(std::size_t) noexcept { }
+constexpr void stats_move(std::size_t) noexcept { }
+
+#endif
+
+} // end detail namespace
+
+/**
+ * @brief Return a snapshot of the shared buffer statistics.
+ *
+ * The values are read one at a time, so a snapshot taken while other threads are
+ * using shared buffers is not an atomic view across all of the values.
+ */
+inline shared_buffer_stats shared_buffer_stats_snapshot() noexcept {
+  shared_buffer_stats st;
+#if defined(SHARED_BUFFER_ENABLE_STATS)
+  auto ld = [] (const std::atomic<std::uint64_t>& ctr) { return ctr.load(std::memory_order_relaxed); };
+  const auto& sd { detail::stats_data };
+  st.allocations = ld(sd.allocations);
+  st.reallocations = ld(sd.reallocations);
+  st.deep_copies = ld(sd.deep_copies);
+  st.bytes_copied = ld(sd.bytes_copied);
+  st.zero_copy_moves = ld(sd.zero_copy_moves);
+  st.bytes_moved = ld(sd.bytes_moved);
+  st.live_buffers = ld(sd.live_buffers);
+  st.live_bytes = ld(sd.live_bytes);
+  st.peak_live_bytes = ld(sd.peak_live_bytes);
+  for (std::size_t i = 0u; i < st.size_histogram.size(); ++i) {
+    st.size_histogram[i] = ld(sd.size_histogram[i]);
+  }
+#endif
+  return st;
+}
+
+/**
+ * @brief Reset the event counters (allocations, copies, and so on) to zero, and the
+ * peak live byte count to the current live byte count.
+ *
+ * The live buffer and live byte counts describe storage that currently exists, so
+ * they are not reset.
+ */
+inline void reset_shared_buffer_stats() noexcept {
+#if defined(SHARED_BUFFER_ENABLE_STATS)
+  auto& sd { detail::stats_data };
+  for (auto* ctr : { &sd.allocations, &sd.reallocations, &sd.deep_copies, &sd.bytes_copied,
+                     &sd.zero_copy_moves, &sd.bytes_moved }) {
+    ctr->store(0u, std::memory_order_relaxed);
+  }
+  for (auto& ctr : sd.size_histogram) {
+    ctr.store(0u, std::memory_order_relaxed);
+  }
+  sd.peak_live_bytes.store(sd.live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+#endif
+}
+
+namespace detail {
+
+template <std::size_t Align>
+struct alignas(Align) aligned_chunk {
+  std::byte bytes[Align];
+};
+
+// allocate the reference count and the bytes in one block, skipping the 
+// zero fill when the library supports it, since the bytes are always 
+// overwritten by the caller; a std::pmr::memory_resource pointer can be 
+// passed in place of an allocator
+template <typename Alloc>
+std::shared_ptr<std::byte[]> make_byte_block(const Alloc& alloc, std::size_t sz) {
+  if constexpr (std::is_convertible_v<Alloc, std::pmr::memory_resource*>) {
+    return make_byte_block(std::pmr::polymorphic_allocator<std::byte>(alloc), sz);
+  }
+  else if constexpr (requires { Alloc::alignment; }) {
+    // an allocator with an alignment (such as aligned_allocator); the block is an 
+    // array of over-aligned chunks, so the bytes start on the alignment wherever 
+    // the library places the reference count
+    using chunk = aligned_chunk<Alloc::alignment>;
+    using chunk_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<chunk>;
+    auto cnt { (sz + Alloc::alignment - 1u) / Alloc::alignment };
+#if defined(__cpp_lib_smart_ptr_for_overwrite)
+    auto blk { std::allocate_shared_for_overwrite<chunk[]>(stats_block_alloc(chunk_alloc(alloc), sz), cnt) };
+#else
+    auto blk { std::allocate_shared<chunk[]>(stats_block_alloc(chunk_alloc(alloc), sz), cnt) };
+#endif
+    auto ptr { reinterpret_cast<std::byte*>(blk.get()) };
+    return std::shared_ptr<std::byte[]>(std::move(blk), ptr);
+  }
+  else {
+#if defined(__cpp_lib_smart_ptr_for_overwrite)
+    return std::allocate_shared_for_overwrite<std::byte[]>(stats_block_alloc(alloc, sz), sz);
+#else
+    return std::allocate_shared<std::byte[]>(stats_block_alloc(alloc, sz), sz);
+#endif
+  }
+}
+
+// take ownership of foreign memory, the deleter is called with the original pointer;
+// if the reference count cannot be allocated the deleter is called before the 
+// exception propagates
+template <typename Alloc, typename T, typename D>
+std::shared_ptr<const std::byte> adopt_bytes(const Alloc& alloc, T* buf, D&& deleter) {
+  if constexpr (std::is_convertible_v<Alloc, std::pmr::memory_resource*>) {
+    return adopt_bytes(std::pmr::polymorphic_allocator<std::byte>(alloc), buf, std::forward<D>(deleter));
+  }
+  else {
+    return std::shared_ptr<const std::byte>(static_cast<const std::byte*>(static_cast<const void*>(buf)),
+        [buf, d = std::forward<D>(deleter)] (const std::byte*) mutable { d(buf); }, alloc);
+  }
+}
+
+// number of bytes in sz elements of type T, where a void pointer counts bytes
+template <typename T>
+constexpr std::size_t byte_size(std::size_t sz) noexcept {
+  if constexpr (std::is_void_v<T>) {
+    return sz;
+  }
+  else {
+    return sz * sizeof(T);
+  }
+}
+
+// byte comparisons use std::memcmp, which the standard libraries implement with 
+// vectorized (SSE2 / AVX2 / NEON) code selected for the running CPU; handles 
+// referring to the same storage compare without looking at the bytes
+inline bool equal_bytes(const std::byte* lp, std::size_t lsz, 
+                        const std::byte* rp, std::size_t rsz) noexcept {
+  if (lsz != rsz) {
+    return false;
+  }
+  return lp == rp || lsz == 0u || std::memcmp(lp, rp, lsz) == 0;
+}
+
+inline std::strong_ordering compare_bytes(const std::byte* lp, std::size_t lsz, 
+                                          const std::byte* rp, std::size_t rsz) noexcept {
+  auto n { std::min(lsz, rsz) };
+  if (lp != rp && n != 0u) {
+    if (auto r = std::memcmp(lp, rp, n); r != 0) {
+      return r <=> 0;
+    }
+  }
+  return lsz <=> rsz;
+}
+
+// 64 bit wyhash (final version 4), a fast non-cryptographic hash; the reads are 
+// in native byte order, so hash values are not portable between platforms
+inline void wy_mum(std::uint64_t& a, std::uint64_t& b) noexcept {
+#if defined(__SIZEOF_INT128__)
+  __extension__ using u128 = unsigned __int128;
+  auto r { static_cast<u128>(a) * b };
+  a = static_cast<std::uint64_t>(r);
+  b = static_cast<std::uint64_t>(r >> 64u);
+#else
+  std::uint64_t ha { a >> 32u }, hb { b >> 32u }, la { a & 0xffffffffu }, lb { b & 0xffffffffu };
+  std::uint64_t rh { ha * hb }, rm0 { ha * lb }, rm1 { hb * la }, rl { la * lb };
+  std::uint64_t t { rl + (rm0 << 32u) };
+  std::uint64_t c { t < rl ? 1u : 0u };
+  std::uint64_t lo { t + (rm1 << 32u) };
+  c += lo < t ? 1u : 0u;
+  a = lo;
+  b = rh + (rm0 >> 32u) + (rm1 >> 32u) + c;
+#endif
+}
+
+inline std::uint64_t wy_mix(std::uint64_t a, std::uint64_t b) noexcept {
+  wy_mum(a, b);
+  return a ^ b;
+}
+
+inline std::uint64_t wy_r8(const std::byte* p) noexcept {
+  std::uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline std::uint64_t wy_r4(const std::byte* p) noexcept {
+  std::uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline std::uint64_t wy_r3(const std::byte* p, std::size_t k) noexcept {
+  return (std::to_integer<std::uint64_t>(p[0]) << 16u) | 
+         (std::to_integer<std::uint64_t>(p[k >> 1u]) << 8u) | 
+         std::to_integer<std::uint64_t>(p[k - 1u]);
+}
+
+inline std::uint64_t hash_bytes(const std::byte* p, std::size_t len, 
+                                std::uint64_t seed = 0u) noexcept {
+  constexpr std::uint64_t secret[] { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 
+                                     0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+  seed ^= wy_mix(seed ^ secret[0], secret[1]);
+  std::uint64_t a { 0u };
+  std::uint64_t b { 0u };
+  if (len <= 16u) {
+    if (len >= 4u) {
+      auto off { (len >> 3u) << 2u };
+      a = (wy_r4(p) << 32u) | wy_r4(p + off);
+      b = (wy_r4(p + len - 4u) << 32u) | wy_r4(p + len - 4u - off);
+    }
+    else if (len > 0u) {
+      a = wy_r3(p, len);
+    }
+  }
+  else {
+    auto i { len };
+    if (i >= 48u) {
+      auto see1 { seed };
+      auto see2 { seed };
+      do {
+        seed = wy_mix(wy_r8(p) ^ secret[1], wy_r8(p + 8u) ^ seed);
+        see1 = wy_mix(wy_r8(p + 16u) ^ secret[2], wy_r8(p + 24u) ^ see1);
+        see2 = wy_mix(wy_r8(p + 32u) ^ secret[3], wy_r8(p + 40u) ^ see2);
+        p += 48u;
+        i -= 48u;
+      } while (i >= 48u);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16u) {
+      seed = wy_mix(wy_r8(p) ^ secret[1], wy_r8(p + 8u) ^ seed);
+      i -= 16u;
+      p += 16u;
+    }
+    a = wy_r8(p + i - 16u);
+    b = wy_r8(p + i - 8u);
+  }
+  a ^= secret[1];
+  b ^= seed;
+  wy_mum(a, b);
+  return wy_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+// values that can be written and read in a specific byte order
+template <typename T>
+concept endian_value = (std::integral<T> || std::floating_point<T>) && !std::is_same_v<T, bool> &&
+                       (sizeof(T) == 1u || sizeof(T) == 2u || sizeof(T) == 4u || sizeof(T) == 8u);
+
+template <std::size_t N>
+struct uint_of;
+template <> struct uint_of<1u> { using type = std::uint8_t; };
+template <> struct uint_of<2u> { using type = std::uint16_t; };
+template <> struct uint_of<4u> { using type = std::uint32_t; };
+template <> struct uint_of<8u> { using type = std::uint64_t; };
+
+template <typename U>
+U byteswap(U v) noexcept {
+  if constexpr (sizeof(U) == 1u) {
+    return v;
+  }
+#if defined(__GNUC__) || defined(__clang__)
+  else if constexpr (sizeof(U) == 2u) {
+    return __builtin_bswap16(v);
+  }
+  else if constexpr (sizeof(U) == 4u) {
+    return __builtin_bswap32(v);
+  }
+  else {
+    return __builtin_bswap64(v);
+  }
+#elif defined(_MSC_VER)
+  else if constexpr (sizeof(U) == 2u) {
+    return _byteswap_ushort(v);
+  }
+  else if constexpr (sizeof(U) == 4u) {
+    return _byteswap_ulong(v);
+  }
+  else {
+    return _byteswap_uint64(v);
+  }
+#else
+  else {
+    U r { 0u };
+    for (std::size_t i = 0u; i < sizeof(U); ++i) {
+      r = static_cast<U>((r << 8u) | (v & 0xffu));
+      v = static_cast<U>(v >> 8u);
+    }
+    return r;
+  }
+#endif
+}
+
+static_assert(std::endian::native == std::endian::big || std::endian::native == std::endian::little,
+              "mixed endian platforms are not supported");
+
+// write a value in the given byte order, returning the number of bytes written
+template <std::endian E, endian_value T>
+std::size_t store_endian(std::byte* p, T val) noexcept {
+  using U = typename uint_of<sizeof(T)>::type;
+  auto u { std::bit_cast<U>(val) };
+  if constexpr (E != std::endian::native) {
+    u = byteswap(u);
+  }
+  std::memcpy(p, &u, sizeof(U));
+  return sizeof(U);
+}
+
+template <std::endian E, endian_value T>
+T load_endian(const std::byte* p) noexcept {
+  using U = typename uint_of<sizeof(T)>::type;
+  U u;
+  std::memcpy(&u, p, sizeof(U));
+  if constexpr (E != std::endian::native) {
+    u = byteswap(u);
+  }
+  return std::bit_cast<T>(u);
+}
+
+// element types whose bytes can be copied by the templated pointer, span, and range
+// constructors and append methods; copying the values of pointers is almost always
+// a mistake, so pointer elements are not allowed
+template <typename T>
+concept byte_copyable = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>;
+
+// one byte element types, such as char, unsigned char, std::uint8_t, and std::byte
+template <typename T>
+concept byte_like = std::is_trivially_copyable_v<T> && sizeof(T) == 1u;
+
+// iterators for the iterator range constructors; contiguous iterators of one byte
+// elements are copied with a single memcpy, any other iterators must produce
+// std::byte values, so that an element by element copy from a std::list<char> (or
+// a narrowing copy of wider elements) does not compile by accident
+template <typename It>
+concept byte_iterator = std::input_iterator<It> &&
+                        ((std::contiguous_iterator<It> && byte_like<std::iter_value_t<It>>) ||
+                         std::same_as<std::iter_value_t<It>, std::byte>);
+
+// contiguous ranges, such as std::vector, std::array, and std::string, whose bytes
+// are copied with a single memcpy
+template <typename R>
+concept contiguous_byte_range = std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+                                byte_copyable<std::ranges::range_value_t<R>>;
+
+// the bytes of a contiguous iterator range of one byte elements
+template <std::contiguous_iterator It>
+std::span<const std::byte> contiguous_bytes(It beg, It end) noexcept {
+  return std::as_bytes(std::span<const std::iter_value_t<It>>(std::to_address(beg),
+                                                              static_cast<std::size_t>(end - beg)));
+}
+
+template <contiguous_byte_range R>
+std::span<const std::byte> range_bytes(const R& r) noexcept {
+  return std::as_bytes(std::span<const std::ranges::range_value_t<R>>(std::ranges::data(r),
+                                                                      std::ranges::size(r)));
+}
+
+// a contiguous piece of bytes for a batch append, either convertible to a span
+// (std::array, std::vector, std::span) or a buffer with data and size methods
+template <typename P>
+concept byte_piece = std::convertible_to<const P&, std::span<const std::byte>> ||
+                     requires (const P& p) {
+                       { p.data() } -> std::convertible_to<const std::byte*>;
+                       { p.size() } -> std::convertible_to<std::size_t>;
+                     };
+
+template <byte_piece P>
+std::span<const std::byte> as_byte_span(const P& p) noexcept {
+  if constexpr (std::convertible_to<const P&, std::span<const std::byte>>) {
+    return p;
+  }
+  else {
+    return { p.data(), p.size() };
+  }
+}
+
+// holds a copy of an allocator; allocators that are not assignable (such as 
+// std::pmr::polymorphic_allocator) are replaced on assignment, and stateless 
+// allocators take no space
+template <typename A, bool = std::is_copy_assignable_v<A>>
+class alloc_holder {
+private:
+  [[no_unique_address]] A m_alloc;
+
+public:
+  explicit alloc_holder(const A& alloc) noexcept : m_alloc(alloc) { }
+  const A& get() const noexcept { return m_alloc; }
+};
+
+template <typename A>
+class alloc_holder<A, false> {
+private:
+  A m_alloc;
+
+public:
+  explicit alloc_holder(const A& alloc) noexcept : m_alloc(alloc) { }
+  alloc_holder(const alloc_holder&) = default;
+  alloc_holder& operator=(const alloc_holder& rhs) noexcept {
+    if (this != &rhs) {
+      std::destroy_at(&m_alloc);
+      std::construct_at(&m_alloc, rhs.m_alloc);
+    }
+    return *this;
+  }
+  const A& get() const noexcept { return m_alloc; }
+};
+
+} // end detail namespace
+
 class const_shared_buffer;
+class local_const_shared_buffer;
+
+/**
+ * @brief Trait for allocators whose memory must stay in place, such as memory that is
+ * registered with the kernel for fixed buffer IO.
+ *
+ * Small payloads are normally copied out of the @c std::vector when moved into a 
+ * @c const_shared_buffer (see @c SHARED_BUFFER_INLINE_SIZE). Specializing this trait
+ * as @c std::true_type for an allocator disables the copy, so the bytes of a moved
+ * buffer always stay in the memory they were written to. When the bytes of such a buffer
+ * are copied into a @c const_shared_buffer, @c std::allocator is used for the copy.
+ */
+template <typename Alloc>
+struct keeps_buffer_storage : std::false_type { };
+
+namespace detail {
+
+// whether the bytes of a moved in vector using this allocator are copied into one block
+template <typename Alloc>
+constexpr bool copy_inline(std::size_t sz) noexcept {
+  return sz <= SHARED_BUFFER_INLINE_SIZE && !keeps_buffer_storage<Alloc>::value;
+}
+
+// allocator used when copying the bytes of a buffer into a const_shared_buffer
+template <typename Alloc>
+auto copy_allocator(const Alloc& alloc) noexcept {
+  if constexpr (keeps_buffer_storage<Alloc>::value) {
+    return std::allocator<std::byte>();
+  }
+  else {
+    return alloc;
+  }
+}
+
+} // end detail namespace
+
+/**
+ * @brief Reference count policy using @c std::shared_ptr, which is safe to copy and
+ * destroy concurrently from multiple threads; this is the default.
+ *
+ * A reference count policy provides a @c pointer alias template for the owning pointer
+ * type, and a static @c make function template that allocates an object along with its
+ * reference count using an allocator.
+ */
+struct atomic_ref_count {
+  template <typename T>
+  using pointer = std::shared_ptr<T>;
+
+  template <typename T, typename Alloc, typename... Args>
+  static pointer<T> make(const Alloc& alloc, Args&&... args) {
+    return std::allocate_shared<T>(alloc, std::forward<Args>(args)...);
+  }
+};
+
+/**
+ * @brief Reference count policy adaptor making copies of a @c basic_mutable_shared_buffer 
+ * copy on write.
+ *
+ * Copies share the internal buffer until one of them is modified. A modifying method 
+ * (the non-const @c data method, @c append, @c resize, @c reserve, @c get_byte_vec, and 
+ * similar) called while other objects share the internal buffer first clones it, so 
+ * modifications are never visible through other objects. Copies that are never modified 
+ * never copy any bytes.
+ *
+ * @tparam Base Underlying reference count policy.
+ */
+template <typename Base = atomic_ref_count>
+struct cow_ref_count : Base {
+  static constexpr bool copy_on_write = true;
+};
+
+namespace detail {
+
+template <typename RefCount>
+constexpr bool is_copy_on_write = requires { requires RefCount::copy_on_write; };
+
+// reference count policies using std::shared_ptr, which a const_shared_buffer can share
+template <typename RefCount>
+concept shared_ptr_ref_count = 
+    std::same_as<typename RefCount::template pointer<std::byte>, std::shared_ptr<std::byte>>;
+
+} // end detail namespace
+
+/**
+ * @brief Growth policy that uses the @c std::vector growth; this is the default.
+ */
+struct vector_growth { };
+
+/**
+ * @brief Growth policy that multiplies the capacity by a ratio when the buffer grows.
+ *
+ * @tparam Num Numerator of the growth ratio.
+ *
+ * @tparam Den Denominator of the growth ratio.
+ */
+template <std::size_t Num = 2u, std::size_t Den = 1u>
+struct geometric_growth {
+  static_assert(Num > Den, "Geometric growth ratio must be greater than one");
+  static constexpr std::size_t next_capacity(std::size_t cap, std::size_t required) noexcept {
+    return std::max(required, cap / Den * Num + cap % Den * Num / Den);
+  }
+};
+
+/**
+ * @brief Growth policy that doubles the capacity when the buffer grows, rounded up to
+ * a multiple of a page size.
+ *
+ * This is useful for large buffers, where the allocation is backed by whole pages.
+ *
+ * @tparam PageSz Page size, must be a power of two.
+ */
+template <std::size_t PageSz = 4096u>
+struct page_growth {
+  static_assert((PageSz & (PageSz - 1u)) == 0u, "Page size must be a power of two");
+  static constexpr std::size_t next_capacity(std::size_t cap, std::size_t required) noexcept {
+    return (std::max(required, 2u * cap) + PageSz - 1u) & ~(PageSz - 1u);
+  }
+};
+
+/**
+ * @brief Growth policy that grows the capacity to exactly the required size.
+ *
+ * This avoids over-allocation on memory constrained systems, but repeated small 
+ * appends will reallocate every time, so it is best used with @c reserve or when 
+ * the buffer is appended to only a few times.
+ */
+struct exact_growth {
+  static constexpr std::size_t next_capacity(std::size_t, std::size_t required) noexcept {
+    return required;
+  }
+};
+
+/**
+ * @brief An allocator adaptor that default initializes, instead of value initializes,
+ * elements constructed without arguments.
+ *
+ * For @c std::byte this means that @c std::vector @c resize (and similar) does not 
+ * zero fill new elements. A @c basic_mutable_shared_buffer using this allocator 
+ * will not zero fill bytes in @c resize_uninitialized or @c append_uninitialized.
+ * All other construction is forwarded to the underlying allocator.
+ *
+ * @tparam T Element type.
+ *
+ * @tparam A Underlying allocator.
+ */
+template <typename T, typename A = std::allocator<T>>
+class default_init_allocator : public A {
+  using traits = std::allocator_traits<A>;
+
+public:
+  template <typename U>
+  struct rebind {
+    using other = default_init_allocator<U, typename traits::template rebind_alloc<U>>;
+  };
+
+  using A::A;
+
+  default_init_allocator() = default;
+  default_init_allocator(const A& a) noexcept : A(a) { }
+
+  template <typename U>
+  void construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>) {
+    ::new (static_cast<void*>(ptr)) U;
+  }
+  template <typename U, typename... Args>
+  void construct(U* ptr, Args&&... args) {
+    traits::construct(static_cast<A&>(*this), ptr, std::forward<Args>(args)...);
+  }
+};
 
 /**
  * @brief A mutable (modifiable) byte buffer class with convenience methods, internally 
@@ -109,43 +956,180 @@ class const_shared_buffer;
  *
  * This class is similar to @c const_shared_buffer, but with mutable characteristics.
  *
- * @invariant There will always be an internal buffer of data, even if the size is zero.
+ * The allocator template parameter is used for both the reference count (through 
+ * @c std::allocate_shared) and the @c std::vector byte storage. The @c mutable_shared_buffer
+ * alias uses @c std::allocator, and the @c chops::pmr::mutable_shared_buffer alias uses
+ * @c std::pmr::polymorphic_allocator, allowing a @c std::pmr::memory_resource pointer to
+ * be passed to any constructor taking an allocator.
+ *
+ * The growth policy template parameter controls how much capacity is reserved when
+ * the buffer grows (through @c append, @c resize, and similar methods). The default 
+ * uses the @c std::vector growth, while @c geometric_growth, @c page_growth, and 
+ * @c exact_growth are alternatives. A growth policy is a type with a static 
+ * @c next_capacity function, taking the current capacity and the required size, and 
+ * returning the new capacity.
+ *
+ * The reference count policy template parameter selects the owning pointer type. The
+ * default, @c atomic_ref_count, uses @c std::shared_ptr. The @c local_ref_count policy
+ * (in @c local_shared_buffer.hpp) uses a non-atomic reference count for buffers that 
+ * never cross threads.
+ *
+ * A read offset supports parsing messages from the front of an accumulating buffer
+ * (e.g. a receive buffer): @c consume advances the offset in constant time, 
+ * @c readable returns the bytes past the offset, and @c compact removes the consumed
+ * bytes from the internal buffer when the space is wanted. The offset belongs to this
+ * object (it is not shared with copies), and the consumed bytes are still part of 
+ * @c data and @c size until @c compact is called.
+ *
+ * @tparam Alloc Allocator for @c std::byte, used for all internal memory.
+ *
+ * @tparam Growth Growth policy.
+ *
+ * @tparam RefCount Reference count policy.
+ *
+ * The internal buffer is created on first use, so a default constructed (or moved from)
+ * @c mutable_shared_buffer does not allocate memory. Such an empty buffer has a null
+ * @c data pointer.
  *
  * @note Modifying the underlying buffer of data (for example by writing bytes using the 
  * @c data method, or appending data) will show up in any other @c mutable_shared_buffer 
- * objects that have been copied to or from the original object.
+ * objects that have been copied to or from the original object. An empty buffer that
+ * has not created its internal buffer yet has nothing to share, so copies of it are
+ * independent. With the @c cow_ref_count policy (e.g. @c cow_mutable_shared_buffer),
+ * copies are instead cloned on the first modification, so they behave as independent
+ * values.
  *
  */
 
-class mutable_shared_buffer {
+template <typename Alloc = std::allocator<std::byte>, typename Growth = vector_growth,
+          typename RefCount = atomic_ref_count>
+class basic_mutable_shared_buffer {
 public:
-  using byte_vec = std::vector<std::byte>;
+  using allocator_type = Alloc;
+  using growth_policy = Growth;
+  using ref_count_policy = RefCount;
+  using byte_vec = std::vector<std::byte, Alloc>;
   using size_type = typename byte_vec::size_type;
 
 private:
-  std::shared_ptr<byte_vec> m_data;
+  using pointer = typename RefCount::template pointer<byte_vec>;
+
+  [[no_unique_address]] detail::alloc_holder<Alloc> m_alloc;
+  pointer m_data;
+  size_type m_consumed { 0u }; // read offset, see consume and readable
 
 private:
 
   friend class const_shared_buffer;
+  friend class local_const_shared_buffer;
+
+  // the internal buffer is created on first use, so that empty buffers do not allocate;
+  // with copy on write, a shared internal buffer is cloned before it is modified
+  byte_vec& storage() {
+    if (!m_data) {
+      m_data = make_byte_vec(m_alloc.get(), size_type(0));
+      m_consumed = 0u; // e.g. after being moved from
+    }
+    else if constexpr (detail::is_copy_on_write<RefCount>) {
+      if (m_data.use_count() > 1) {
+        auto cp { make_byte_vec(m_alloc.get(), size_type(0)) };
+        cp->reserve(m_data->capacity());
+        cp->insert(cp->end(), m_data->cbegin(), m_data->cend());
+        detail::stats_sync(*cp);
+        detail::stats_copy(cp->size());
+        m_data = std::move(cp);
+      }
+      else {
+        // pairs with the release of the last other reference, whose reads of the 
+        // bytes must happen before the bytes are modified here
+        std::atomic_thread_fence(std::memory_order_acquire);
+      }
+    }
+    return *m_data;
+  }
 
-  friend bool operator==(const mutable_shared_buffer&, const const_shared_buffer&) noexcept;
-  friend bool operator==(const const_shared_buffer&, const mutable_shared_buffer&) noexcept;
+  byte_vec& grow_for(size_type required) {
+    auto& vec { storage() };
+    if constexpr (requires { Growth::next_capacity(size_type(), size_type()); }) {
+      auto cap = vec.capacity();
+      if (required > cap) {
+        vec.reserve(std::max(required, static_cast<size_type>(Growth::next_capacity(cap, required))));
+      }
+    }
+    return vec;
+  }
+
+  // one growth for a batch of appends; with the std::vector growth (where reserve is
+  // exact) the capacity at least doubles, so that repeated batches have amortized growth
+  byte_vec& grow_batch(size_type required) {
+    auto& vec { grow_for(required) };
+    if (required > vec.capacity()) {
+      vec.reserve(std::max(required, 2u * vec.capacity()));
+    }
+    return vec;
+  }
+
+  // the vector is constructed first and then moved into the shared block, since 
+  // allocators such as std::pmr::polymorphic_allocator perform uses-allocator
+  // construction of the vector while others do not
+  template <typename... Args>
+  static pointer make_byte_vec(const allocator_type& alloc, Args&&... args) {
+    return RefCount::template make<detail::storage_vec<byte_vec>>(alloc, 
+                                                   byte_vec(std::forward<Args>(args)..., alloc));
+  }
+
+  template <typename InIt>
+  static pointer make_range_vec(const allocator_type& alloc, InIt beg, InIt end) {
+    if constexpr (std::contiguous_iterator<InIt>) {
+      auto sp { detail::contiguous_bytes(beg, end) };
+      return make_byte_vec(alloc, sp.data(), sp.data()+sp.size());
+    }
+    else {
+      return make_byte_vec(alloc, beg, end);
+    }
+  }
+
+  // capacity is already reserved, so there is no reallocation (and no zero fill)
+  static void append_piece(byte_vec& vec, std::span<const std::byte> sp) {
+    vec.insert(vec.end(), sp.begin(), sp.end());
+  }
+
+  // the values are written into a local array, then appended with a single growth
+  template <std::endian E, typename... Ts>
+  basic_mutable_shared_buffer& append_endian(Ts... vals) {
+    std::byte tmp[(0u + ... + sizeof(Ts))];
+    std::byte* p { tmp };
+    ((p += detail::store_endian<E>(p, vals)), ...);
+    return append(tmp, sizeof(tmp));
+  }
 
 public:
 
   // default copy and move construction, copy and move assignment
-  mutable_shared_buffer(const mutable_shared_buffer&) = default;
-  mutable_shared_buffer(mutable_shared_buffer&&) = default;
-  mutable_shared_buffer& operator=(const mutable_shared_buffer&) = default;
-  mutable_shared_buffer& operator=(mutable_shared_buffer&&) = default;
+  basic_mutable_shared_buffer(const basic_mutable_shared_buffer&) = default;
+  basic_mutable_shared_buffer(basic_mutable_shared_buffer&&) = default;
+  basic_mutable_shared_buffer& operator=(const basic_mutable_shared_buffer&) = default;
+  basic_mutable_shared_buffer& operator=(basic_mutable_shared_buffer&&) = default;
 
 /**
  * @brief Default construct the @c mutable_shared_buffer.
  *
+ * No memory is allocated until the buffer is modified.
+ *
  */
-  mutable_shared_buffer() noexcept : 
-      m_data{std::make_shared<byte_vec>(size_type(0))} { }
+  basic_mutable_shared_buffer() noexcept : 
+      basic_mutable_shared_buffer(allocator_type()) { }
+
+/**
+ * @brief Construct an empty @c mutable_shared_buffer using the supplied allocator.
+ *
+ * No memory is allocated until the buffer is modified.
+ *
+ * @param alloc Allocator (or @c std::pmr::memory_resource pointer for the @c pmr
+ * alias) used for all internal memory.
+ */
+  explicit basic_mutable_shared_buffer(const allocator_type& alloc) noexcept : 
+      m_alloc(alloc), m_data() { }
 
 /**
  * @brief Construct by copying from a @c std::span of @c std::byte.
@@ -155,8 +1139,9 @@ public:
  *
  */
   template <std::size_t Ext>
-  explicit mutable_shared_buffer(std::span<const std::byte, Ext> sp) : 
-      m_data{std::make_shared<byte_vec>(sp.data(), sp.data()+sp.size())} { }
+  explicit basic_mutable_shared_buffer(std::span<const std::byte, Ext> sp, 
+                                       const allocator_type& alloc = allocator_type()) : 
+      m_alloc(alloc), m_data{make_byte_vec(alloc, sp.data(), sp.data()+sp.size())} { }
 
 /**
  * @brief Construct by copying from a @c std::byte array.
@@ -172,8 +1157,9 @@ public:
  * @param sz Size of buffer.
  *
  */
-  mutable_shared_buffer(const std::byte* buf, std::size_t sz) : 
-      mutable_shared_buffer(std::as_bytes(std::span<const std::byte>{buf, sz})) { }
+  basic_mutable_shared_buffer(const std::byte* buf, std::size_t sz, 
+                              const allocator_type& alloc = allocator_type()) : 
+      basic_mutable_shared_buffer(std::as_bytes(std::span<const std::byte>{buf, sz}), alloc) { }
 
 /**
  * @brief Move construct from a @c std::vector of @c std::bytes.
@@ -185,9 +1171,11 @@ public:
  * "moved from" state (as it typical with move operations).
  *
  */
-  explicit mutable_shared_buffer(byte_vec&& bv) noexcept : 
-      m_data{std::make_shared<byte_vec>(size_type(0))} {
-    *m_data = std::move(bv);
+  explicit basic_mutable_shared_buffer(byte_vec&& bv) noexcept : 
+      m_alloc(bv.get_allocator()), 
+      m_data{RefCount::template make<detail::adopted_storage_vec<byte_vec>>(bv.get_allocator(), 
+                                                                            std::move(bv))} {
+    detail::stats_move(m_data->size());
   }
 
 /**
@@ -199,31 +1187,46 @@ public:
  * buffer.
  *
  * @param sz Size for internal @c std::byte buffer.
+ *
+ * @param alloc Allocator used for all internal memory.
  */
-  explicit mutable_shared_buffer(size_type sz) : 
-      m_data{std::make_shared<byte_vec>(sz)} { }
+  explicit basic_mutable_shared_buffer(size_type sz, const allocator_type& alloc = allocator_type()) : 
+      m_alloc(alloc), m_data{make_byte_vec(alloc, sz, std::byte{0})} { }
 
 
 /**
  * @brief Construct by copying bytes from a @c std::span.
  *
- * The type of the span must be convertible to or be layout compatible with
- * @c std::byte.
+ * The element type of the span must be trivially copyable, and not a pointer.
  *
  * @param sp @c std::span pointing to buffer of data. The @c std::span 
  * pointer is cast into a @c std::byte pointer and bytes are then copied. 
  *
  */
-  template <typename T, std::size_t Ext>
-  mutable_shared_buffer(std::span<const T, Ext> sp) : 
-      mutable_shared_buffer(std::as_bytes(sp)) { }
+  template <detail::byte_copyable T, std::size_t Ext>
+  basic_mutable_shared_buffer(std::span<const T, Ext> sp, const allocator_type& alloc = allocator_type()) : 
+      basic_mutable_shared_buffer(std::as_bytes(sp), alloc) { }
+
+/**
+ * @brief Construct by copying the bytes of a contiguous range, such as a @c std::vector,
+ * @c std::array, or @c std::string, with a single copy.
+ *
+ * This is the same as constructing from a @c std::span of the range. Note that a
+ * string literal is a @c char array which includes the terminating null character.
+ *
+ * @param r Contiguous range of trivially copyable (non pointer) elements.
+ */
+  template <detail::contiguous_byte_range R>
+  explicit basic_mutable_shared_buffer(const R& r, const allocator_type& alloc = allocator_type()) : 
+      basic_mutable_shared_buffer(detail::range_bytes(r), alloc) { }
 
 /**
  * @brief Construct by copying bytes from an arbitrary pointer.
  *
  * The pointer passed into this constructor is cast into a @c std::byte pointer and bytes 
  * are then copied. In particular, this method can be used for @c char pointers, 
- * @c void pointers, @c unsigned @c char pointers, etc.
+ * @c unsigned @c char pointers, etc. The pointed to type must be trivially copyable,
+ * and not a pointer.
  *
  * @pre Size cannot be greater than the source buffer.
  *
@@ -231,22 +1234,32 @@ public:
  *
  * @param sz Size of buffer, in bytes.
  */
-  template <typename T>
-  mutable_shared_buffer(const T* buf, size_type sz) : 
-      mutable_shared_buffer(std::as_bytes(std::span<const T>{buf, sz})) { }
+  template <detail::byte_copyable T>
+  basic_mutable_shared_buffer(const T* buf, size_type sz, const allocator_type& alloc = allocator_type()) : 
+      basic_mutable_shared_buffer(std::as_bytes(std::span<const T>{buf, sz}), alloc) { }
 
 /**
  * @brief Construct from input iterators.
  *
- * @pre Valid iterator range, where each element is convertible to a @c std::byte.
+ * Contiguous iterators (such as pointers, or @c std::vector and @c std::string
+ * iterators) of one byte elements, e.g. @c char or @c std::uint8_t, are copied with a
+ * single memcpy. Other iterators must have a value type of @c std::byte, so an element
+ * by element copy from a @c std::list<char> does not compile.
+ *
+ * @pre Valid iterator range.
  *
  * @param beg Beginning input iterator of range.
  * @param end Ending input iterator of range.
  *
  */
-  template <typename InIt>
-  mutable_shared_buffer(InIt beg, InIt end) : 
-      m_data(std::make_shared<byte_vec>(beg, end)) { }
+  template <detail::byte_iterator InIt>
+  basic_mutable_shared_buffer(InIt beg, InIt end, const allocator_type& alloc = allocator_type()) : 
+      m_alloc(alloc), m_data(make_range_vec(alloc, beg, end)) { }
+
+/**
+ * @brief Return a copy of the allocator used for internal memory.
+ */
+  allocator_type get_allocator() const noexcept { return m_alloc.get(); }
 
 /**
  * @brief Return @c std::byte pointer to beginning of buffer.
@@ -258,9 +1271,15 @@ public:
  * Accessing past the end of the internal buffer (as defined by the @c size() 
  * method) results in undefined behavior.
  *
- * @return @c std::byte pointer to buffer.
+ * With the @c cow_ref_count policy a shared internal buffer is cloned first, since
+ * the bytes may be written through the pointer.
+ *
+ * @return @c std::byte pointer to buffer, which is null if the internal buffer has
+ * not been created yet.
  */
-  std::byte* data() noexcept { return m_data->data(); }
+  std::byte* data() noexcept(!detail::is_copy_on_write<RefCount>) { 
+    return m_data ? storage().data() : nullptr;
+  }
 
 /**
  * @brief Return @c const @c std::byte pointer to beginning of buffer.
@@ -269,33 +1288,37 @@ public:
  *
  * @return @c const @c std::byte pointer to buffer.
  */
-  const std::byte* data() const noexcept { return m_data->data(); }
+  const std::byte* data() const noexcept { return m_data ? m_data->data() : nullptr; }
 
 /**
  * @brief Return size (number of bytes) of buffer.
  *
  * @return Size of buffer, which may be zero.
  */
-  size_type size() const noexcept { return m_data->size(); }
+  size_type size() const noexcept { return m_data ? m_data->size() : 0u; }
 
 /**
  * @brief Return access to underlying @c std::vector.
  *
  * This can be used to instantiate a @c dynamic_buffer as defined in the Networking TS
- * or Asio API. Changing the @c std::vector from outside this class works because no 
+ * or Asio API (although @c dynamic_shared_buffer in @c asio_shared_buffer.hpp avoids
+ * the zero filling and front erasing of that adapter). Changing the @c std::vector from outside this class works because no 
  * state data is stored within this object that needs to be consistent with the 
- * @c std::vector contents.
+ * @c std::vector contents (the read offset is only a position, and @c readable
+ * is empty if the @c std::vector is shrunk below it).
+ *
+ * The internal buffer is created if it does not exist yet.
  *
  * @return Reference to @c std::vector<std::byte>.
  */
-  byte_vec& get_byte_vec() noexcept { return *m_data; }
+  byte_vec& get_byte_vec() { return storage(); }
 
 /**
  * @brief Query to see if size is zero.
  *
  * @return @c true if empty (size equals zero).
  */
-  bool empty() const noexcept { return m_data->empty(); }
+  bool empty() const noexcept { return size() == 0u; }
 
 /**
  * @brief Clear the internal contents back to an empty state.
@@ -306,7 +1329,18 @@ public:
  * buffer into a known and empty state.
  *
  */
-  void clear() noexcept { m_data->clear(); }
+  void clear() noexcept {
+    m_consumed = 0u;
+    if constexpr (detail::is_copy_on_write<RefCount>) {
+      if (m_data.use_count() > 1) {
+        m_data.reset(); // other objects keep the bytes
+        return;
+      }
+    }
+    if (m_data) {
+      m_data->clear();
+    }
+  }
 
 /**
  * @brief Resize internal buffer.
@@ -318,14 +1352,166 @@ public:
  * Resizing to zero results in an empty buffer, although calling @c clear is 
  * preferred.
  */
-  void resize(size_type sz) { m_data->resize(sz); }
+  void resize(size_type sz) {
+    auto& vec { grow_for(sz) };
+    vec.resize(sz, std::byte{0});
+    detail::stats_sync(vec);
+  }
+
+/**
+ * @brief Reserve capacity in the internal buffer, so that the buffer can grow to (at 
+ * least) the given size without reallocating.
+ *
+ * @param cap New capacity; if less than the current capacity, nothing is done.
+ */
+  void reserve(size_type cap) {
+    auto& vec { storage() };
+    vec.reserve(cap);
+    detail::stats_sync(vec);
+  }
+
+/**
+ * @brief Return the capacity of the internal buffer.
+ *
+ * @return Number of bytes the buffer can hold without reallocating.
+ */
+  size_type capacity() const noexcept { return m_data ? m_data->capacity() : 0u; }
+
+/**
+ * @brief Request that unused capacity be released.
+ *
+ * As with @c std::vector, this is a non-binding request.
+ */
+  void shrink_to_fit() {
+    if (m_data) {
+      auto& vec { storage() };
+      vec.shrink_to_fit();
+      detail::stats_sync(vec);
+    }
+  }
+
+/**
+ * @brief Resize internal buffer, without initializing any new bytes.
+ *
+ * This is useful when the new bytes will be immediately overwritten, for example
+ * by a network read or by serializing data. The zero fill is skipped when the
+ * allocator default initializes elements, such as @c default_init_allocator; with 
+ * @c std::allocator (which always value initializes) the new bytes are zero.
+ *
+ * @param sz New size for buffer. The size can also be contracted.
+ *
+ * @return @c std::span referring to the whole buffer. The contents of new bytes
+ * are unspecified.
+ */
+  std::span<std::byte> resize_uninitialized(size_type sz) {
+    auto& vec { grow_for(sz) };
+    vec.resize(sz);
+    detail::stats_sync(vec);
+    return { vec.data(), vec.size() };
+  }
+
+/**
+ * @brief Append space to the end of the internal buffer, without initializing the 
+ * new bytes.
+ *
+ * See @c resize_uninitialized for details on when the zero fill is skipped.
+ *
+ * @param sz Number of bytes to append.
+ *
+ * @return @c std::span referring to the appended bytes, to be written into. The
+ * @c std::span is invalidated when the buffer is modified.
+ */
+  std::span<std::byte> append_uninitialized(size_type sz) {
+    size_type old_sz = size();
+    resize_uninitialized(old_sz + sz);
+    return { data() + old_sz, sz };
+  }
+
+/**
+ * @brief Return the number of @c mutable_shared_buffer objects sharing the internal
+ * buffer (including this one).
+ */
+  long use_count() const noexcept { return m_data.use_count(); }
 
 /**
  * @brief Swap with the contents of another @c mutable_shared_buffer object.
  */
-  void swap(mutable_shared_buffer& rhs) noexcept {
+  void swap(basic_mutable_shared_buffer& rhs) noexcept {
     using std::swap; // swap idiom
+    swap(m_alloc, rhs.m_alloc);
     swap(m_data, rhs.m_data);
+    swap(m_consumed, rhs.m_consumed);
+  }
+
+/**
+ * @brief Mark bytes at the front of the readable bytes as consumed, without moving
+ * any bytes.
+ *
+ * When all of the bytes have been consumed the buffer is cleared (keeping its 
+ * capacity), so a receive buffer that is parsed to the end never needs compaction.
+ *
+ * The read offset belongs to this object, not to the shared internal buffer. Since
+ * clearing (here) and @c compact modify the internal buffer, the read offset is only
+ * meaningful while the internal buffer is not shared with other objects, except with
+ * the @c cow_ref_count policy, where a shared internal buffer is cloned (or released)
+ * first and each copy has its own read offset.
+ *
+ * @pre @c n cannot be greater than @c readable().size().
+ *
+ * @pre The internal buffer is not shared (@c use_count() no greater than 1), unless
+ * the reference count policy is copy on write.
+ *
+ * @param n Number of bytes consumed.
+ */
+  void consume(size_type n) noexcept {
+    m_consumed += n;
+    if (m_consumed >= size()) {
+      assert(detail::is_copy_on_write<RefCount> || use_count() <= 1);
+      clear();
+    }
+  }
+
+/**
+ * @brief Return the bytes not yet consumed.
+ *
+ * @return @c std::span referring to the bytes from the read offset to the end of the
+ * buffer. The @c std::span is invalidated when the buffer is modified.
+ */
+  std::span<const std::byte> readable() const noexcept {
+    return m_consumed < size() ? 
+      std::span<const std::byte>{ data() + m_consumed, size() - m_consumed } :
+      std::span<const std::byte>{};
+  }
+
+/**
+ * @brief Return the read offset, the number of bytes consumed since the last
+ * @c compact or @c clear.
+ */
+  size_type consumed() const noexcept { return m_consumed; }
+
+/**
+ * @brief Remove the consumed bytes from the front of the internal buffer, moving the
+ * readable bytes to the front and resetting the read offset to zero.
+ *
+ * This is typically called when the buffer is about to grow, or when the consumed
+ * bytes are a large part of the buffer, instead of after every @c consume.
+ *
+ * @pre The internal buffer is not shared, unless the reference count policy is copy
+ * on write (see @c consume).
+ */
+  void compact() {
+    if (m_consumed == 0u) {
+      return;
+    }
+    assert(detail::is_copy_on_write<RefCount> || use_count() <= 1);
+    if (m_consumed >= size()) {
+      clear();
+      return;
+    }
+    auto n { m_consumed };
+    auto& vec { storage() };
+    vec.erase(vec.begin(), vec.begin() + n);
+    m_consumed = 0u;
   }
 
 /**
@@ -337,10 +1523,10 @@ public:
  *
  * @return Reference to @c this (to allow method chaining).
  */
-  mutable_shared_buffer& append(const std::byte* buf, std::size_t sz) {
-    size_type old_sz = size();
-    resize(old_sz + sz); // set up buffer space
-    std::copy(buf, buf+sz, data()+old_sz);
+  basic_mutable_shared_buffer& append(const std::byte* buf, std::size_t sz) {
+    auto& vec { grow_for(size() + sz) };
+    vec.insert(vec.end(), buf, buf+sz); // bytes are written once, no zero fill
+    detail::stats_sync(vec);
     return *this;
   }
 
@@ -352,7 +1538,7 @@ public:
  * @return Reference to @c this (to allow method chaining).
  */
   template <std::size_t Ext>
-  mutable_shared_buffer& append(std::span<const std::byte, Ext> sp) {
+  basic_mutable_shared_buffer& append(std::span<const std::byte, Ext> sp) {
     return append(sp.data(), sp.size());
   }
 
@@ -361,14 +1547,15 @@ public:
  *
  * The pointer passed into this method is cast into a @c std::byte pointer and bytes 
  * are then copied. In particular, this method can be used for @c char pointers, 
- * @c void pointers, @ unsigned @c char pointers, etc.
+ * @c unsigned @c char pointers, etc. The pointed to type must be trivially copyable,
+ * and not a pointer.
  *
  * @param buf Non-null pointer to a buffer of data.
  *
  * @param sz Size of buffer, in bytes.
  */
-  template <typename T>
-  mutable_shared_buffer& append(const T* buf, std::size_t sz) {
+  template <detail::byte_copyable T>
+  basic_mutable_shared_buffer& append(const T* buf, std::size_t sz) {
     return append(std::as_bytes(std::span<const T>{buf, sz}));
   }
 
@@ -376,20 +1563,32 @@ public:
  * @brief Append a @c std::span that is a non @c std::byte buffer.
  *
  * The @c std::span passed into this method is performs a cast on the
- * data. In particular, this method can be used for @c char pointers, 
- * @c void pointers, @ unsigned @c char pointers, etc.
+ * data. In particular, this method can be used for @c char spans, 
+ * @c unsigned @c char spans, etc.
  *
- * The type of the span must be convertible to or be layout compatible with
- * @c std::byte.
+ * The element type of the span must be trivially copyable, and not a pointer.
  *
  * @param sp @c std::span of arbitrary bytes.
  *
  */
-  template <typename T, std::size_t Ext>
-  mutable_shared_buffer& append(std::span<const T, Ext> sp) {
+  template <detail::byte_copyable T, std::size_t Ext>
+  basic_mutable_shared_buffer& append(std::span<const T, Ext> sp) {
     return append(std::as_bytes(sp));
   }
 
+/**
+ * @brief Append the bytes of a contiguous range, such as a @c std::vector, @c std::array,
+ * or @c std::string, with a single copy.
+ *
+ * @param r Contiguous range of trivially copyable (non pointer) elements.
+ *
+ * @return Reference to @c this (to allow method chaining).
+ */
+  template <detail::contiguous_byte_range R>
+  basic_mutable_shared_buffer& append(const R& r) {
+    return append(detail::range_bytes(r));
+  }
+
 /**
  * @brief Append the contents of another @c mutable_shared_buffer to the end.
  *
@@ -397,7 +1596,7 @@ public:
  *
  * @return Reference to @c this (to allow method chaining).
  */
-  mutable_shared_buffer& append(const mutable_shared_buffer& rhs) {
+  basic_mutable_shared_buffer& append(const basic_mutable_shared_buffer& rhs) {
     return append(rhs.data(), rhs.size());
   }
 
@@ -406,7 +1605,7 @@ public:
  *
  * See @c append method for details.
  */
-  mutable_shared_buffer& operator+=(const mutable_shared_buffer& rhs) {
+  basic_mutable_shared_buffer& operator+=(const basic_mutable_shared_buffer& rhs) {
     return append(rhs);
   }
 
@@ -417,16 +1616,112 @@ public:
  *
  * @return Reference to @c this (to allow method chaining).
  */
-  mutable_shared_buffer& append(std::byte b) {
+  basic_mutable_shared_buffer& append(std::byte b) {
     return append(&b, 1);
   }
 
+/**
+ * @brief Append multiple pieces of bytes, growing the buffer once.
+ *
+ * The total size is computed first, the internal buffer is grown (at most) once, and
+ * then each piece is copied in. This is more efficient than calling @c append for 
+ * each piece, for example when coalescing many small messages into one network write.
+ *
+ * A piece is anything convertible to @c std::span<const @c std::byte> (such as a 
+ * @c std::span, @c std::array, or @c std::vector of @c std::byte), or a buffer with
+ * @c data and @c size methods (such as a @c const_shared_buffer).
+ *
+ * @pre No piece refers to the bytes of this buffer.
+ *
+ * @param pieces Pieces to append, in order.
+ *
+ * @return Reference to @c this (to allow method chaining).
+ */
+  template <detail::byte_piece... Pieces>
+    requires (sizeof...(Pieces) > 0u)
+  basic_mutable_shared_buffer& append_all(const Pieces&... pieces) {
+    auto& vec { grow_batch(size() + (0u + ... + detail::as_byte_span(pieces).size())) };
+    (append_piece(vec, detail::as_byte_span(pieces)), ...);
+    detail::stats_sync(vec);
+    return *this;
+  }
+
+/**
+ * @brief Append a range of pieces of bytes, growing the buffer once.
+ *
+ * See the variadic @c append_all method for details.
+ *
+ * @pre No piece refers to the bytes of this buffer.
+ *
+ * @param pieces Range (e.g. a @c std::vector) of pieces to append, in order.
+ *
+ * @return Reference to @c this (to allow method chaining).
+ */
+  template <std::ranges::forward_range R>
+    requires detail::byte_piece<std::ranges::range_value_t<R>>
+  basic_mutable_shared_buffer& append_all(const R& pieces) {
+    size_type total { size() };
+    for (const auto& p : pieces) {
+      total += detail::as_byte_span(p).size();
+    }
+    auto& vec { grow_batch(total) };
+    for (const auto& p : pieces) {
+      append_piece(vec, detail::as_byte_span(p));
+    }
+    detail::stats_sync(vec);
+    return *this;
+  }
+
+/**
+ * @brief Append arithmetic values in big endian (network) byte order.
+ *
+ * Any number of values can be appended in one call, with the buffer grown once for
+ * all of them. Integral and floating point values of 1, 2, 4, or 8 bytes are 
+ * supported; floating point values are written as their bit pattern.
+ *
+ * The value types can be specified explicitly, which converts the arguments:
+ * @code
+ *   buf.append_be<std::uint16_t, std::uint32_t>(len, seq);
+ * @endcode
+ *
+ * @param val First value to append.
+ *
+ * @param vals Additional values to append.
+ *
+ * @return Reference to @c this (to allow method chaining).
+ */
+  template <detail::endian_value T, detail::endian_value... Ts>
+  basic_mutable_shared_buffer& append_be(T val, Ts... vals) {
+    return append_endian<std::endian::big>(val, vals...);
+  }
+
+/**
+ * @brief Append arithmetic values in little endian byte order.
+ *
+ * See @c append_be for details.
+ */
+  template <detail::endian_value T, detail::endian_value... Ts>
+  basic_mutable_shared_buffer& append_le(T val, Ts... vals) {
+    return append_endian<std::endian::little>(val, vals...);
+  }
+
+/**
+ * @brief Append arithmetic values in network byte order, the same as @c append_be.
+ *
+ * This matches the byte order of the @c append_val function in the Connective C++ 
+ * binary serialize library, without the pointer arithmetic.
+ */
+  template <detail::endian_value T, detail::endian_value... Ts>
+  basic_mutable_shared_buffer& append_val(T val, Ts... vals) {
+    return append_endian<std::endian::big>(val, vals...);
+  }
+
 /**
  * @brief Append a single @c std::byte to the end.
  *
  * See @c append method (single @c std::byte) for details.
  */
-  mutable_shared_buffer& operator+=(std::byte b) {
+  basic_mutable_shared_buffer& operator+=(std::byte b) {
     return append(b);
   }
 
@@ -434,30 +1729,59 @@ public:
  * @brief Compare two @c mutable_shared_buffer objects for internal buffer 
  * byte-by-byte equality.
  *
- * Internally this invokes the @c std::vector @c operator== on @c std::byte 
+ * The comparison is the same as the @c std::vector @c operator== on @c std::byte 
  * elements.
  *
  * @return @c true if @c size() same for each, and each byte compares @c true.
  */
-  bool operator== (const mutable_shared_buffer& rhs) const noexcept { 
-    return *m_data == *rhs.m_data;
+  bool operator== (const basic_mutable_shared_buffer& rhs) const noexcept { 
+    return detail::equal_bytes(data(), size(), rhs.data(), rhs.size());
   }  
 
 /**
  * @brief Compare two @c mutable_shared_buffer objects for internal buffer 
  * byte-by-byte spaceship operator ordering.
  *
- * Internally this invokes the @c std::vector @c <=> on @c std::byte 
+ * The ordering is the same as the @c std::vector @c <=> on @c std::byte 
  * elements.
  *
  * @return Spaceship operator comparison result.
  *
  */
-  auto operator<=>(const mutable_shared_buffer& rhs) const noexcept {
-    return *m_data <=> *rhs.m_data;
+  auto operator<=>(const basic_mutable_shared_buffer& rhs) const noexcept {
+    return detail::compare_bytes(data(), size(), rhs.data(), rhs.size());
   }
 
-}; // end mutable_shared_buffer class
+}; // end basic_mutable_shared_buffer class
+
+/**
+ * @brief The @c mutable_shared_buffer type, using @c std::allocator.
+ */
+using mutable_shared_buffer = basic_mutable_shared_buffer<>;
+
+namespace pmr {
+
+/**
+ * @brief A @c mutable_shared_buffer using @c std::pmr::polymorphic_allocator, so that
+ * internal memory comes from a @c std::pmr::memory_resource.
+ */
+using mutable_shared_buffer = basic_mutable_shared_buffer<std::pmr::polymorphic_allocator<std::byte>>;
+
+/**
+ * @brief A @c cow_mutable_shared_buffer using @c std::pmr::polymorphic_allocator.
+ */
+using cow_mutable_shared_buffer = basic_mutable_shared_buffer<std::pmr::polymorphic_allocator<std::byte>,
+                                                              vector_growth, cow_ref_count<>>;
+
+}
+
+/**
+ * @brief A @c mutable_shared_buffer where copies share the internal buffer until one of
+ * them is modified, see @c cow_ref_count.
+ */
+using cow_mutable_shared_buffer = basic_mutable_shared_buffer<std::allocator<std::byte>, vector_growth, 
+                                                              cow_ref_count<>>;
+
 
 // non-member functions
 /**
@@ -465,7 +1789,9 @@ public:
  *
  */
 
-inline void swap(mutable_shared_buffer& lhs, mutable_shared_buffer& rhs) noexcept {
+template <typename Alloc, typename Growth, typename RefCount>
+void swap(basic_mutable_shared_buffer<Alloc, Growth, RefCount>& lhs, 
+          basic_mutable_shared_buffer<Alloc, Growth, RefCount>& rhs) noexcept {
   lhs.swap(rhs);
 }
 
@@ -480,6 +1806,12 @@ inline void swap(mutable_shared_buffer& lhs, mutable_shared_buffer& rhs) noexcep
  * same (i.e. the internal pointer to the data and the size) for the full lifetime of the 
  * asynchronous operations.
  *
+ * Internally the reference count is shared with whatever owns the bytes (a block 
+ * allocated together with the bytes when they are copied in, or the @c std::vector 
+ * when one is moved in), while the data pointer and size are stored directly in the
+ * @c const_shared_buffer object. This allows a @c const_shared_buffer to refer to a
+ * sub-range (slice) of another @c const_shared_buffer without copying.
+ *
  * @invariant There will always be an internal buffer of data, even if the size is zero.
  *
  */
@@ -489,21 +1821,92 @@ public:
   using byte_vec = std::vector<std::byte>;
   using size_type = typename byte_vec::size_type;
 
+  // payloads up to this size are copied into one block when moved in
+  static constexpr size_type inline_size = SHARED_BUFFER_INLINE_SIZE;
+
 private:
-  std::shared_ptr<byte_vec> m_data;
+  std::shared_ptr<const std::byte> m_data;
+  size_type m_size;
+  mutable std::atomic<std::size_t> m_hash { 0u }; // zero until computed, per object (see hash)
+  const byte_vec* m_vec { nullptr }; // owning vector, when the storage can be reclaimed
 
 private:
 
-  friend bool operator==(const mutable_shared_buffer&, const const_shared_buffer&) noexcept;
-  friend bool operator==(const const_shared_buffer&, const mutable_shared_buffer&) noexcept;
+  template <typename Alloc>
+  static std::shared_ptr<const std::byte> copy_bytes(const Alloc& alloc, 
+                                                     const std::byte* buf, size_type sz) {
+    auto blk { detail::make_byte_block(alloc, sz) };
+    std::copy(buf, buf+sz, blk.get());
+    auto ptr { blk.get() };
+    return std::shared_ptr<const std::byte>(std::move(blk), ptr);
+  }
+
+  template <typename InIt>
+  static const_shared_buffer copy_range(InIt beg, InIt end) {
+    if constexpr (std::contiguous_iterator<InIt>) {
+      return const_shared_buffer(detail::contiguous_bytes(beg, end));
+    }
+    else if constexpr (std::forward_iterator<InIt>) {
+      auto sz { static_cast<size_type>(std::distance(beg, end)) };
+      auto blk { detail::make_byte_block(std::allocator<std::byte>(), sz) };
+      std::transform(beg, end, blk.get(), [] (const auto& b) { return static_cast<std::byte>(b); } );
+      auto ptr { blk.get() };
+      return const_shared_buffer(std::shared_ptr<const std::byte>(std::move(blk), ptr), sz);
+    }
+    else {
+      return from_byte_vec<false>(byte_vec(beg, end));
+    }
+  }
+
+  // the vector is either filled in here (the storage is counted as an allocation) or 
+  // moved in by the application (counted as a zero copy move)
+  template <bool Adopt, typename A>
+  static const_shared_buffer from_byte_vec(std::vector<std::byte, A>&& bv) {
+    using vec_type = std::vector<std::byte, A>;
+    if (detail::copy_inline<A>(bv.size())) {
+      vec_type tmp(std::move(bv)); // moved from state is empty either way
+      return const_shared_buffer(copy_bytes(tmp.get_allocator(), tmp.data(), tmp.size()), tmp.size());
+    }
+    using storage_type = std::conditional_t<Adopt, detail::adopted_storage_vec<vec_type>, 
+                                                   detail::storage_vec<vec_type>>;
+    const_shared_buffer csb(std::shared_ptr<vec_type>(
+                              std::allocate_shared<storage_type>(bv.get_allocator(), std::move(bv))));
+    if constexpr (Adopt) {
+      detail::stats_move(csb.size());
+    }
+    return csb;
+  }
+
+  template <typename A>
+  explicit const_shared_buffer(std::shared_ptr<std::vector<std::byte, A>>&& bvp) noexcept :
+      m_data(), m_size(bvp->size()) {
+    hold_vec(std::move(bvp));
+  }
+
+  // share the reference count of a vector owning the bytes; a std::allocator vector
+  // is remembered so that try_reclaim can hand it back to a mutable_shared_buffer
+  template <typename A>
+  void hold_vec(std::shared_ptr<std::vector<std::byte, A>>&& bvp) noexcept {
+    if constexpr (std::is_same_v<std::vector<std::byte, A>, byte_vec>) {
+      m_vec = bvp.get();
+    }
+    auto ptr { bvp->data() };
+    m_data = std::shared_ptr<const std::byte>(std::move(bvp), ptr);
+  }
 
 public:
 
   const_shared_buffer() = delete;
 
-  // default copy and move construction, should do the right thing
-  const_shared_buffer(const const_shared_buffer&) = default;
-  const_shared_buffer(const_shared_buffer&&) = default;
+  // copy and move construction, the cached hash value is carried along
+  const_shared_buffer(const const_shared_buffer& rhs) noexcept : 
+      m_data(rhs.m_data), m_size(rhs.m_size), 
+      m_hash(rhs.m_hash.load(std::memory_order_relaxed)), m_vec(rhs.m_vec) { }
+  // the moved from object is left empty, with a null data pointer
+  const_shared_buffer(const_shared_buffer&& rhs) noexcept : 
+      m_data(std::move(rhs.m_data)), m_size(std::exchange(rhs.m_size, 0u)), 
+      m_hash(rhs.m_hash.exchange(0u, std::memory_order_relaxed)), 
+      m_vec(std::exchange(rhs.m_vec, nullptr)) { }
   // copy and move assignment disabled
   const_shared_buffer& operator=(const const_shared_buffer&) = delete;
   const_shared_buffer& operator=(const_shared_buffer&&) = delete;
@@ -517,7 +1920,7 @@ public:
  */
   template <std::size_t Ext>
   explicit const_shared_buffer(std::span<const std::byte, Ext> sp) : 
-      m_data(std::make_shared<byte_vec>(sp.data(), sp.data()+sp.size())) { }
+      m_data(copy_bytes(std::allocator<std::byte>(), sp.data(), sp.size())), m_size(sp.size()) { }
 /**
  * @brief Construct by copying from a @c std::byte array.
  *
@@ -534,25 +1937,37 @@ public:
 /**
  * @brief Construct by copying from a @c std::span.
  *
- * The type of the span must be convertible to or be layout compatible with
- * @c std::byte.
+ * The element type of the span must be trivially copyable, and not a pointer.
  *
  * @param sp @c std::span pointing to buffer of data. The @c std::span 
  * pointer is cast into a @c std::byte pointer and bytes are then copied. 
  *
  */
-  template <typename T, std::size_t Ext>
+  template <detail::byte_copyable T, std::size_t Ext>
   const_shared_buffer(std::span<const T, Ext> sp) : 
       const_shared_buffer(std::as_bytes(sp)) { }
+
+/**
+ * @brief Construct by copying the bytes of a contiguous range, such as a @c std::vector,
+ * @c std::array, or @c std::string, with a single copy.
+ *
+ * This is the same as constructing from a @c std::span of the range. Note that a
+ * string literal is a @c char array which includes the terminating null character.
+ *
+ * @param r Contiguous range of trivially copyable (non pointer) elements.
+ */
+  template <detail::contiguous_byte_range R>
+  explicit const_shared_buffer(const R& r) : 
+      const_shared_buffer(detail::range_bytes(r)) { }
+
 /**
  * @brief Construct by copying bytes from an arbitrary pointer.
  *
  * The pointer passed into this constructor is cast into a @c std::byte pointer and bytes 
  * are then copied. In particular, this method can be used for @c char pointers, 
- * @c void pointers, @c unsigned @c char pointers, etc.
+ * @c unsigned @c char pointers, etc.
  *
- * The type of the span must be convertible to or be layout compatible with
- * @c std::byte.
+ * The pointed to type must be trivially copyable, and not a pointer.
  *
  * @pre Size cannot be greater than the source buffer.
  *
@@ -560,21 +1975,101 @@ public:
  *
  * @param sz Size of buffer, in bytes.
  */
-  template <typename T>
+  template <detail::byte_copyable T>
   const_shared_buffer(const T* buf, std::size_t sz) : 
       const_shared_buffer(std::as_bytes(std::span<const T>{buf, sz})) { }
 
+/**
+ * @brief Construct by copying from a @c std::span of @c std::byte, using the supplied
+ * allocator for the internal memory.
+ *
+ * The reference count and the bytes are allocated in one block from the allocator.
+ *
+ * @param alloc Allocator, or @c std::pmr::memory_resource pointer, used for the 
+ * internal memory.
+ *
+ * @param sp @c std::byte span pointing to buffer of data. The data is
+ * copied into the internal buffer of the @c const_shared_buffer. 
+ */
+  template <typename Alloc, std::size_t Ext>
+  const_shared_buffer(std::allocator_arg_t, const Alloc& alloc, std::span<const std::byte, Ext> sp) : 
+      m_data(copy_bytes(alloc, sp.data(), sp.size())), m_size(sp.size()) { }
+
+/**
+ * @brief Construct by copying bytes from an arbitrary pointer, using the supplied
+ * allocator for the internal memory.
+ *
+ * @pre Size cannot be greater than the source buffer.
+ *
+ * @param alloc Allocator, or @c std::pmr::memory_resource pointer, used for the 
+ * internal memory.
+ *
+ * @param buf Non-null pointer to a buffer of data. 
+ *
+ * @param sz Size of buffer, in bytes.
+ */
+  template <typename Alloc, detail::byte_copyable T>
+  const_shared_buffer(std::allocator_arg_t, const Alloc& alloc, const T* buf, std::size_t sz) : 
+      const_shared_buffer(std::allocator_arg, alloc, std::as_bytes(std::span<const T>{buf, sz})) { }
+
+/**
+ * @brief Construct by taking ownership of externally allocated memory, without copying.
+ *
+ * This allows buffers from other libraries (e.g. DPDK, io_uring, protobuf arenas, C 
+ * libraries) to be used with shared buffer lifetime management. When the last 
+ * @c const_shared_buffer referring to the memory (including copies and slices) goes 
+ * away, the deleter is called with the original pointer.
+ *
+ * If the reference count cannot be allocated, the deleter is called and the exception
+ * is rethrown.
+ *
+ * @pre The bytes must not be modified while any @c const_shared_buffer refers to them.
+ *
+ * @param buf Pointer to the memory; a @c void pointer is allowed, in which case 
+ * @c sz is in bytes.
+ *
+ * @param sz Number of elements of type @c T.
+ *
+ * @param deleter Function object called as @c deleter(buf) to release the memory.
+ */
+  template <typename T, typename D>
+    requires std::invocable<D&, T*>
+  const_shared_buffer(T* buf, std::size_t sz, D deleter) : 
+      m_data(detail::adopt_bytes(std::allocator<std::byte>(), buf, std::move(deleter))), 
+      m_size(detail::byte_size<T>(sz)) { }
+
+/**
+ * @brief Construct by taking ownership of externally allocated memory, using the
+ * supplied allocator for the reference count.
+ *
+ * See the constructor taking a pointer, size, and deleter for details.
+ *
+ * @param alloc Allocator, or @c std::pmr::memory_resource pointer, used for the 
+ * reference count.
+ */
+  template <typename Alloc, typename T, typename D>
+    requires std::invocable<D&, T*>
+  const_shared_buffer(std::allocator_arg_t, const Alloc& alloc, T* buf, std::size_t sz, D deleter) : 
+      m_data(detail::adopt_bytes(alloc, buf, std::move(deleter))), 
+      m_size(detail::byte_size<T>(sz)) { }
+
 /**
  * @brief Construct by copying from a @c mutable_shared_buffer object.
  *
  * This constructor will copy from a @c mutable_shared_buffer. There is an alternative
  * constructor that is more efficient which moves from a @c mutable_shared_buffer 
  * instead of copying.
+ *
+ * The allocator of the @c mutable_shared_buffer is used for the internal memory.
  *  
  * @param rhs @c mutable_shared_buffer containing bytes to be copied.
  */
-  explicit const_shared_buffer(const mutable_shared_buffer& rhs) : 
-      const_shared_buffer(rhs.data(), rhs.size()) { }
+  template <typename A, typename G, detail::shared_ptr_ref_count R>
+  explicit const_shared_buffer(const basic_mutable_shared_buffer<A, G, R>& rhs) : 
+      m_data(copy_bytes(detail::copy_allocator(rhs.get_allocator()), rhs.data(), rhs.size())), 
+      m_size(rhs.size()) {
+    detail::stats_copy(m_size);
+  }
 
 /**
  * @brief Construct by moving from a @c mutable_shared_buffer object.
@@ -583,38 +2078,94 @@ public:
  * This allows efficient API boundaries, where application code can construct and fill in a
  * @c mutable_shared_buffer, then @c std::move it into a @c const_shared_buffer for use
  * with asynchronous functions.
+ *
+ * If other @c mutable_shared_buffer objects still share the internal buffer, the bytes
+ * are copied instead of moved, since later modifications through those objects must
+ * not be visible in (or invalidate the data pointer of) the @c const_shared_buffer.
+ *
+ * If the size is not greater than @c inline_size (and the allocator is not marked 
+ * with @c keeps_buffer_storage), the bytes are copied into a single
+ * block along with the reference count, and a uniquely owned @c mutable_shared_buffer
+ * keeps its internal buffer (cleared, with the capacity retained) for reuse.
+ *
+ * Any allocator of the @c mutable_shared_buffer is retained, and is used for the 
+ * memory if the bytes are copied.
  *  
  * @param rhs @c mutable_shared_buffer to be moved from; after moving the 
  * @c mutable_shared_buffer will be empty.
  */
-  explicit const_shared_buffer(mutable_shared_buffer&& rhs) noexcept : 
-      m_data(std::move(rhs.m_data)) {
-    rhs.m_data = std::make_shared<byte_vec>(0); // set rhs back to invariant
+  template <typename A, typename G, detail::shared_ptr_ref_count R>
+  explicit const_shared_buffer(basic_mutable_shared_buffer<A, G, R>&& rhs) : 
+      m_data(), m_size(rhs.size()) {
+    auto alloc { rhs.get_allocator() };
+    const auto& src { rhs }; // const access, never clones a copy on write buffer
+    if (detail::copy_inline<A>(m_size)) {
+      m_data = copy_bytes(alloc, src.data(), src.size());
+      detail::stats_copy(m_size);
+      if (rhs.m_data.use_count() == 1) {
+        rhs.clear();
+        return;
+      }
+    }
+    else if (rhs.m_data.use_count() == 1) {
+      hold_vec(std::move(rhs.m_data));
+      detail::stats_move(m_size);
+    }
+    else {
+      m_data = copy_bytes(detail::copy_allocator(alloc), src.data(), src.size());
+      detail::stats_copy(m_size);
+    }
+    rhs.m_data.reset(); // rhs is empty, without allocating
   }
 
+/**
+ * @brief Construct from a @c std::shared_ptr that keeps the bytes alive, without 
+ * copying.
+ *
+ * The @c std::shared_ptr is typically an aliasing pointer, where the reference count
+ * belongs to whatever owns the bytes (for example an object holding the bytes as a 
+ * data member). The @c const_shared_buffer shares that reference count.
+ *
+ * @pre The pointer must refer to at least @c sz bytes, which must not be modified
+ * while any @c const_shared_buffer refers to them.
+ *
+ * @param dp @c std::shared_ptr pointing to the first byte.
+ *
+ * @param sz Number of bytes.
+ */
+  const_shared_buffer(std::shared_ptr<const std::byte> dp, size_type sz) noexcept :
+      m_data(std::move(dp)), m_size(sz) { }
+
 /**
  * @brief Move construct from a @c std::vector of @c std::bytes.
  *
  * Efficiently construct from a @c std::vector of @c std::bytes by moving
- * into a @c const_shared_buffer.
+ * into a @c const_shared_buffer. The allocator of the @c std::vector is also
+ * used for the reference count.
+ *
+ * If the size is not greater than @c inline_size, the bytes are copied into a single
+ * block along with the reference count instead.
  *
  */
-  explicit const_shared_buffer(byte_vec&& bv) noexcept :
-      m_data(std::make_shared<byte_vec>()) { 
-    *m_data = std::move(bv);
-  }
+  template <typename A>
+  explicit const_shared_buffer(std::vector<std::byte, A>&& bv) :
+      const_shared_buffer(from_byte_vec<true>(std::move(bv))) { }
 
 /**
  * @brief Construct from input iterators.
  *
- * @pre Valid iterator range, where each element is convertible to a @c std::byte.
+ * Contiguous iterators of one byte elements are copied with a single memcpy, other
+ * iterators must have a value type of @c std::byte (see the @c mutable_shared_buffer
+ * iterator constructor).
+ *
+ * @pre Valid iterator range.
  *
  * @param beg Beginning input iterator of range.
  * @param end Ending input iterator of range.
  *
  */
-  template <typename InIt>
-  const_shared_buffer(InIt beg, InIt end) : m_data(std::make_shared<byte_vec>(beg, end)) { }
+  template <detail::byte_iterator InIt>
+  const_shared_buffer(InIt beg, InIt end) : const_shared_buffer(copy_range(beg, end)) { }
 
 /**
  * @brief Return @c const @c std::byte pointer to beginning of buffer.
@@ -628,47 +2179,150 @@ public:
  *
  * @return @c const @c std::byte pointer to buffer.
  */
-  const std::byte* data() const noexcept { return m_data->data(); }
+  const std::byte* data() const noexcept { return m_data.get(); }
 
 /**
  * @brief Return size (number of bytes) of buffer.
  *
  * @return Size of buffer, which may be zero.
  */
-  size_type size() const noexcept { return m_data->size(); }
+  size_type size() const noexcept { return m_size; }
 
 /**
  * @brief Query to see if size is zero.
  *
  * @return @c true if empty (size equals zero).
  */
-  bool empty() const noexcept { return (*m_data).empty(); }
+  bool empty() const noexcept { return m_size == 0u; }
+
+/**
+ * @brief Return a @c const_shared_buffer that refers to a sub-range of this buffer, 
+ * without copying any bytes.
+ *
+ * The returned object shares the reference count with this object, so the internal
+ * buffer is kept alive as long as either object (or any copy) exists. This allows a 
+ * large buffer (e.g. the result of one socket read) to be split into multiple messages,
+ * each with correct lifetime management.
+ *
+ * @pre @c offset @c + @c length cannot be greater than @c size().
+ *
+ * @param offset Starting offset of the sub-range.
+ *
+ * @param length Number of bytes in the sub-range.
+ *
+ * @return @c const_shared_buffer referring to the sub-range.
+ */
+  const_shared_buffer slice(size_type offset, size_type length) const noexcept {
+    return const_shared_buffer(std::shared_ptr<const std::byte>(m_data, data() + offset), length);
+  }
+
+/**
+ * @brief Return a @c const_shared_buffer that refers to the bytes from an offset to the 
+ * end of this buffer, without copying any bytes.
+ *
+ * See the two parameter @c slice method for details.
+ *
+ * @pre @c offset cannot be greater than @c size().
+ *
+ * @param offset Starting offset of the sub-range.
+ *
+ * @return @c const_shared_buffer referring to the sub-range.
+ */
+  const_shared_buffer slice(size_type offset) const noexcept {
+    return slice(offset, size() - offset);
+  }
 
 /**
  * @brief Compare two @c const_shared_buffer objects for internal buffer 
  * byte-by-byte equality.
  *
- * Internally this invokes the @c std::vector @c operator== on @c std::byte 
- * elements.
- *
  * @return @c true if @c size() same for each, and each byte compares @c true.
  *
  */
   bool operator== (const const_shared_buffer& rhs) const noexcept { 
-    return *m_data == *rhs.m_data;
+    auto lh { m_hash.load(std::memory_order_relaxed) };
+    auto rh { rhs.m_hash.load(std::memory_order_relaxed) };
+    if (lh != 0u && rh != 0u && lh != rh) {
+      return false;
+    }
+    return detail::equal_bytes(data(), size(), rhs.data(), rhs.size());
   } 
 /**
  * @brief Compare two @c const_shared_buffer objects for internal buffer 
  * byte-by-byte spaceship operator ordering.
  *
- * Internally this invokes the @c std::vector @c <=> on @c std::byte 
- * elements.
+ * The ordering is lexicographical on @c std::byte elements, the same as the 
+ * @c std::vector @c <=> ordering.
  *
  * @return Spaceship operator comparison result.
  *
  */
   auto operator<=> (const const_shared_buffer& rhs) const noexcept {
-    return *m_data <=> *rhs.m_data;
+    return detail::compare_bytes(data(), size(), rhs.data(), rhs.size());
+  }
+
+/**
+ * @brief Move the storage back into a @c mutable_shared_buffer, without copying, if 
+ * this is the only object referring to it.
+ *
+ * This closes the loop on the buffer lifecycle: serialize into a @c mutable_shared_buffer,
+ * move it into a @c const_shared_buffer for an asynchronous write, then when the write
+ * completes reclaim the storage (and its capacity) for the next message instead of
+ * freeing and allocating again.
+ *
+ * Reclaiming succeeds when the bytes are owned by a @c std::vector using 
+ * @c std::allocator, which is the case for a buffer (larger than @c inline_size) that 
+ * was moved in from a @c mutable_shared_buffer or a @c std::vector, and the object 
+ * refers to the whole vector (not a slice), and no other @c const_shared_buffer 
+ * (including slices) refers to the storage.
+ *
+ * @return @c mutable_shared_buffer holding the storage, with this object left empty 
+ * (zero size and a null data pointer, as with a moved from object); otherwise an empty @c std::optional, with this object 
+ * unchanged.
+ */
+  std::optional<mutable_shared_buffer> try_reclaim() && noexcept {
+    if (m_vec == nullptr || m_data.use_count() != 1 || 
+        m_data.get() != m_vec->data() || m_size != m_vec->size()) {
+      return { };
+    }
+    // pairs with the release of the last other reference, whose reads of the 
+    // bytes must happen before the bytes are modified through the mutable buffer
+    std::atomic_thread_fence(std::memory_order_acquire);
+    mutable_shared_buffer msb;
+    msb.m_data = std::shared_ptr<byte_vec>(std::move(m_data), const_cast<byte_vec*>(m_vec));
+    detail::stats_move(m_size);
+    m_size = 0u;
+    m_hash.store(0u, std::memory_order_relaxed);
+    m_vec = nullptr;
+    return msb;
+  }
+
+/**
+ * @brief Return a hash value of the bytes of the buffer.
+ *
+ * The hash is a fast non-cryptographic hash (wyhash). It is computed on the first call
+ * and cached in this object, and copies of this object (made after the first call)
+ * start with the cached value, so repeated lookups in hashed containers pay for
+ * hashing the bytes only once.
+ *
+ * The cache is a data member rather than part of the shared storage, since the storage
+ * can be memory with no room for it (a moved in @c std::vector, external memory with a
+ * deleter, or an aliasing @c std::shared_ptr), and slices share the storage while 
+ * hashing different bytes. This adds a @c std::size_t to every @c const_shared_buffer
+ * object, and copies made before the first call compute the hash separately.
+ *
+ * Calling this method concurrently on the same object is safe.
+ *
+ * @return Hash value; equal buffers have equal hash values.
+ */
+  std::size_t hash() const noexcept {
+    auto h { m_hash.load(std::memory_order_relaxed) };
+    if (h == 0u) {
+      h = static_cast<std::size_t>(detail::hash_bytes(data(), size()));
+      h = (h == 0u) ? 1u : h; // zero is reserved for "not computed"
+      m_hash.store(h, std::memory_order_relaxed);
+    }
+    return h;
   }
 
 }; // end const_shared_buffer class
@@ -681,8 +2335,9 @@ public:
  *
  * @return @c true if @c size() same for each, and each byte compares @c true.
  */
-inline bool operator== (const const_shared_buffer& lhs, const mutable_shared_buffer& rhs) noexcept { 
-  return *lhs.m_data == *rhs.m_data;
+template <typename A, typename G, typename R>
+bool operator== (const const_shared_buffer& lhs, const basic_mutable_shared_buffer<A, G, R>& rhs) noexcept { 
+  return detail::equal_bytes(lhs.data(), lhs.size(), rhs.data(), rhs.size());
 }  
 
 /**
@@ -691,11 +2346,24 @@ inline bool operator== (const const_shared_buffer& lhs, const mutable_shared_buf
  *
  * @return @c true if @c size() same for each, and each byte compares @c true.
  */
-inline bool operator== (const mutable_shared_buffer& lhs, const const_shared_buffer& rhs) noexcept { 
-  return *lhs.m_data == *rhs.m_data;
+template <typename A, typename G, typename R>
+bool operator== (const basic_mutable_shared_buffer<A, G, R>& lhs, const const_shared_buffer& rhs) noexcept { 
+  return detail::equal_bytes(lhs.data(), lhs.size(), rhs.data(), rhs.size());
 }  
 
 } // end namespace
 
-#endif
+/**
+ * @brief @c std::hash specialization for @c const_shared_buffer, hashing the bytes.
+ *
+ * This allows @c const_shared_buffer objects to be used as keys in @c std::unordered_map
+ * and @c std::unordered_set. See @c const_shared_buffer::hash.
+ */
+template <>
+struct std::hash<chops::const_shared_buffer> {
+  std::size_t operator()(const chops::const_shared_buffer& buf) const noexcept {
+    return buf.hash();
+  }
+};
 
+#endif
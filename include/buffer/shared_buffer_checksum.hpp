@@ -0,0 +1,490 @@
+/** @file
+ *
+ * @brief CRC32C and Adler-32 checksums over shared buffers and buffer sequences,
+ * computed incrementally, in parallel, and cached alongside a @c const_shared_buffer.
+ *
+ * Both checksums can be continued (the previous value is passed in) and combined
+ * (two values computed independently are joined, given the length of the second), so
+ * a checksum can be computed while data is appended to a @c mutable_shared_buffer
+ * instead of in a separate pass over the finished buffer:
+ *
+ * @code
+ *   chops::mutable_shared_buffer msg;
+ *   chops::crc32c_checksum ck;
+ *   chops::append_checksummed(msg, ck, header, body); // bytes are still in cache
+ *   chops::checksummed_buffer out(chops::const_shared_buffer(std::move(msg)), ck);
+ * @endcode
+ *
+ * Or across the segments of a @c shared_buffer_sequence in parallel, with
+ * @c parallel_crc32c.
+ *
+ * The CRC32C (Castagnoli) computation uses the SSE4.2 or ARMv8 CRC instructions when
+ * the compiler targets them (e.g. @c -msse4.2, @c -march=native, or @c -march=armv8-a+crc),
+ * otherwise a portable slicing-by-8 table implementation. The values are the same as
+ * those of iSCSI, SCTP, ext4, and other users of CRC32C.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SHARED_BUFFER_CHECKSUM_HPP_INCLUDED
+#define SHARED_BUFFER_CHECKSUM_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <cstring> // std::memcpy
+#include <array>
+#include <span>
+#include <vector>
+#include <thread> // std::jthread, std::thread::hardware_concurrency
+#include <algorithm> // std::min, std::max
+
+#if defined(__SSE4_2__) || defined(__AVX__)
+#include <nmmintrin.h> // _mm_crc32_u8, _mm_crc32_u64
+#define SHARED_BUFFER_CRC32C_SSE42
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h> // __crc32cb, __crc32cd
+#define SHARED_BUFFER_CRC32C_ARM
+#endif
+
+#include "buffer/shared_buffer.hpp"
+#include "buffer/shared_buffer_sequence.hpp"
+
+namespace chops {
+
+namespace detail {
+
+// reflected CRC32C (Castagnoli) polynomial
+inline constexpr std::uint32_t crc32c_poly { 0x82F63B78u };
+
+// slicing-by-8 tables, table[0] is the usual byte at a time table
+constexpr std::array<std::array<std::uint32_t, 256u>, 8u> make_crc32c_tables() noexcept {
+  std::array<std::array<std::uint32_t, 256u>, 8u> tbl { };
+  for (std::uint32_t i = 0u; i < 256u; ++i) {
+    std::uint32_t crc { i };
+    for (int b = 0; b < 8; ++b) {
+      crc = (crc & 1u) ? (crc >> 1) ^ crc32c_poly : crc >> 1;
+    }
+    tbl[0][i] = crc;
+  }
+  for (std::size_t k = 1u; k < 8u; ++k) {
+    for (std::size_t i = 0u; i < 256u; ++i) {
+      tbl[k][i] = (tbl[k-1u][i] >> 8) ^ tbl[0][tbl[k-1u][i] & 0xFFu];
+    }
+  }
+  return tbl;
+}
+
+inline constexpr auto crc32c_tables { make_crc32c_tables() };
+
+inline std::uint32_t load_le32(const std::byte* p) noexcept {
+  return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+         (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+// portable implementation, works on the un-inverted crc register
+inline std::uint32_t crc32c_sw(std::uint32_t crc, const std::byte* p, std::size_t n) noexcept {
+  const auto& t { crc32c_tables };
+  while (n >= 8u) {
+    std::uint32_t lo { crc ^ load_le32(p) };
+    std::uint32_t hi { load_le32(p + 4u) };
+    crc = t[7][lo & 0xFFu] ^ t[6][(lo >> 8) & 0xFFu] ^ t[5][(lo >> 16) & 0xFFu] ^ t[4][lo >> 24] ^
+          t[3][hi & 0xFFu] ^ t[2][(hi >> 8) & 0xFFu] ^ t[1][(hi >> 16) & 0xFFu] ^ t[0][hi >> 24];
+    p += 8u;
+    n -= 8u;
+  }
+  while (n-- > 0u) {
+    crc = t[0][(crc ^ static_cast<std::uint32_t>(*p++)) & 0xFFu] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+inline std::uint32_t crc32c_hw(std::uint32_t crc, const std::byte* p, std::size_t n) noexcept {
+#if defined(SHARED_BUFFER_CRC32C_SSE42) && (defined(__x86_64__) || defined(_M_X64))
+  std::uint64_t crc64 { crc };
+  for (; n >= 8u; p += 8u, n -= 8u) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    crc64 = _mm_crc32_u64(crc64, v);
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+  for (; n > 0u; ++p, --n) {
+    crc = _mm_crc32_u8(crc, static_cast<unsigned char>(*p));
+  }
+  return crc;
+#elif defined(SHARED_BUFFER_CRC32C_ARM)
+  for (; n >= 8u; p += 8u, n -= 8u) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    crc = __crc32cd(crc, v);
+  }
+  for (; n > 0u; ++p, --n) {
+    crc = __crc32cb(crc, static_cast<std::uint8_t>(*p));
+  }
+  return crc;
+#else
+  return crc32c_sw(crc, p, n);
+#endif
+}
+
+// multiply two polynomials modulo the CRC32C polynomial, reflected bit order
+constexpr std::uint32_t crc32c_multmodp(std::uint32_t a, std::uint32_t b) noexcept {
+  std::uint32_t m { 1u << 31 };
+  std::uint32_t p { 0u };
+  while (m != 0u) {
+    if (a & m) {
+      p ^= b;
+    }
+    b = (b & 1u) ? (b >> 1) ^ crc32c_poly : b >> 1;
+    m >>= 1;
+  }
+  return p;
+}
+
+// x^(2^k) modulo the CRC32C polynomial
+constexpr std::array<std::uint32_t, 32u> make_crc32c_x2n_table() noexcept {
+  std::array<std::uint32_t, 32u> tbl { };
+  std::uint32_t p { 1u << 30 }; // x^1
+  tbl[0] = p;
+  for (std::size_t k = 1u; k < 32u; ++k) {
+    p = crc32c_multmodp(p, p);
+    tbl[k] = p;
+  }
+  return tbl;
+}
+
+inline constexpr auto crc32c_x2n_table { make_crc32c_x2n_table() };
+
+// x^(8 * len) modulo the CRC32C polynomial, i.e. the effect of appending len zero bytes
+constexpr std::uint32_t crc32c_shift(std::uint64_t len) noexcept {
+  std::uint32_t p { 1u << 31 }; // x^0
+  for (std::size_t k = 3u; len != 0u; len >>= 1, ++k) {
+    if (len & 1u) {
+      p = crc32c_multmodp(crc32c_x2n_table[k & 31u], p);
+    }
+  }
+  return p;
+}
+
+inline constexpr std::uint32_t adler_base { 65521u };
+inline constexpr std::size_t adler_nmax { 5552u }; // largest run before the sums can overflow
+
+// the crc of the logical bytes [beg, end) of a sequence of segments
+inline std::uint32_t crc32c_of_range(std::span<const const_shared_buffer> segs,
+                                     std::size_t beg, std::size_t end) noexcept {
+  std::uint32_t crc { ~0u };
+  std::size_t off { 0u };
+  for (const auto& seg : segs) {
+    std::size_t seg_beg { off };
+    off += seg.size();
+    if (off <= beg) {
+      continue;
+    }
+    if (seg_beg >= end) {
+      break;
+    }
+    std::size_t b { (std::max)(beg, seg_beg) - seg_beg };
+    std::size_t e { (std::min)(end, off) - seg_beg };
+    crc = crc32c_hw(crc, seg.data() + b, e - b);
+  }
+  return ~crc;
+}
+
+} // end detail namespace
+
+/**
+ * @brief Compute, or continue computing, the CRC32C of a piece of bytes.
+ *
+ * @param piece A @c std::span of @c std::byte, or anything with @c data and @c size
+ * methods returning bytes, such as a @c const_shared_buffer or @c mutable_shared_buffer.
+ *
+ * @param crc The CRC32C of the preceding bytes, zero (the default) to start.
+ *
+ * @return The CRC32C of the preceding bytes followed by the bytes of @c piece.
+ */
+template <detail::byte_piece P>
+std::uint32_t crc32c(const P& piece, std::uint32_t crc = 0u) noexcept {
+  auto sp { detail::as_byte_span(piece) };
+  return ~detail::crc32c_hw(~crc, sp.data(), sp.size());
+}
+
+/**
+ * @brief Compute, or continue computing, the CRC32C of the segments of a
+ * @c shared_buffer_sequence, in order.
+ */
+inline std::uint32_t crc32c(const shared_buffer_sequence& seq, std::uint32_t crc = 0u) noexcept {
+  for (const auto& seg : seq) {
+    crc = crc32c(seg, crc);
+  }
+  return crc;
+}
+
+/**
+ * @brief Combine two CRC32C values computed independently.
+ *
+ * @param crc1 CRC32C of the first bytes.
+ *
+ * @param crc2 CRC32C of the second bytes.
+ *
+ * @param len2 Number of second bytes.
+ *
+ * @return The CRC32C of the first bytes followed by the second bytes.
+ */
+constexpr std::uint32_t crc32c_combine(std::uint32_t crc1, std::uint32_t crc2, std::uint64_t len2) noexcept {
+  return detail::crc32c_multmodp(detail::crc32c_shift(len2), crc1) ^ crc2;
+}
+
+/**
+ * @brief Compute, or continue computing, the Adler-32 checksum of a piece of bytes.
+ *
+ * @param piece A @c std::span of @c std::byte, or anything with @c data and @c size
+ * methods returning bytes.
+ *
+ * @param adler The Adler-32 of the preceding bytes, one (the default) to start.
+ */
+template <detail::byte_piece P>
+std::uint32_t adler32(const P& piece, std::uint32_t adler = 1u) noexcept {
+  auto sp { detail::as_byte_span(piece) };
+  const std::byte* p { sp.data() };
+  std::size_t n { sp.size() };
+  std::uint32_t a { adler & 0xFFFFu };
+  std::uint32_t b { adler >> 16 };
+  while (n > 0u) {
+    std::size_t run { (std::min)(n, detail::adler_nmax) };
+    n -= run;
+    for (; run > 0u; --run) {
+      a += static_cast<std::uint32_t>(*p++);
+      b += a;
+    }
+    a %= detail::adler_base;
+    b %= detail::adler_base;
+  }
+  return a | (b << 16);
+}
+
+/**
+ * @brief Combine two Adler-32 values computed independently, in the same way as
+ * @c crc32c_combine.
+ */
+constexpr std::uint32_t adler32_combine(std::uint32_t adler1, std::uint32_t adler2, std::uint64_t len2) noexcept {
+  constexpr std::uint32_t base { detail::adler_base };
+  auto rem { static_cast<std::uint32_t>(len2 % base) };
+  std::uint32_t sum1 { adler1 & 0xFFFFu };
+  std::uint32_t sum2 { static_cast<std::uint32_t>((static_cast<std::uint64_t>(rem) * sum1) % base) };
+  sum1 += (adler2 & 0xFFFFu) + base - 1u;
+  sum2 += (adler1 >> 16) + (adler2 >> 16) + base - rem;
+  if (sum1 >= base) { sum1 -= base; }
+  if (sum1 >= base) { sum1 -= base; }
+  if (sum2 >= (base << 1)) { sum2 -= (base << 1); }
+  if (sum2 >= base) { sum2 -= base; }
+  return sum1 | (sum2 << 16);
+}
+
+/**
+ * @brief An incrementally computed CRC32C, along with the number of bytes covered.
+ *
+ * The byte count allows checksums of consecutive pieces, computed separately (or on
+ * separate threads), to be combined.
+ */
+class crc32c_checksum {
+private:
+  std::uint32_t m_value { 0u };
+  std::uint64_t m_size { 0u };
+
+public:
+  constexpr crc32c_checksum() noexcept = default;
+
+/**
+ * @brief Add bytes to the checksum.
+ *
+ * @return Reference to @c this (to allow method chaining).
+ */
+  crc32c_checksum& update(std::span<const std::byte> sp) noexcept {
+    m_value = crc32c(sp, m_value);
+    m_size += sp.size();
+    return *this;
+  }
+
+/**
+ * @brief Add the bytes covered by another checksum, as if they followed the bytes
+ * covered by this checksum.
+ */
+  constexpr crc32c_checksum& combine(const crc32c_checksum& rhs) noexcept {
+    m_value = crc32c_combine(m_value, rhs.m_value, rhs.m_size);
+    m_size += rhs.m_size;
+    return *this;
+  }
+
+  constexpr std::uint32_t value() const noexcept { return m_value; }
+  constexpr std::uint64_t size() const noexcept { return m_size; }
+};
+
+/**
+ * @brief An incrementally computed Adler-32 checksum, along with the number of bytes
+ * covered; the interface is the same as @c crc32c_checksum.
+ */
+class adler32_checksum {
+private:
+  std::uint32_t m_value { 1u };
+  std::uint64_t m_size { 0u };
+
+public:
+  constexpr adler32_checksum() noexcept = default;
+
+  adler32_checksum& update(std::span<const std::byte> sp) noexcept {
+    m_value = adler32(sp, m_value);
+    m_size += sp.size();
+    return *this;
+  }
+
+  constexpr adler32_checksum& combine(const adler32_checksum& rhs) noexcept {
+    m_value = adler32_combine(m_value, rhs.m_value, rhs.m_size);
+    m_size += rhs.m_size;
+    return *this;
+  }
+
+  constexpr std::uint32_t value() const noexcept { return m_value; }
+  constexpr std::uint64_t size() const noexcept { return m_size; }
+};
+
+namespace detail {
+
+// bytes copied before the checksum is updated from them, small enough to stay in cache
+inline constexpr std::size_t checksum_block_size { 32u * 1024u };
+
+} // end detail namespace
+
+/**
+ * @brief Append pieces to a mutable buffer and add the appended bytes to a checksum,
+ * while they are still in cache.
+ *
+ * The space for all of the pieces is appended once (with @c append_uninitialized),
+ * then each piece is copied in blocks of @c detail::checksum_block_size bytes, and
+ * the checksum is updated from each block right after it is copied, so a large
+ * payload is not read a second time from memory.
+ *
+ * @param buf Buffer to append to, typically a @c mutable_shared_buffer.
+ *
+ * @param ck Checksum to update, such as a @c crc32c_checksum.
+ *
+ * @param pieces Pieces to append, see @c append_all.
+ *
+ * @return Reference to @c buf.
+ */
+template <typename Buf, typename Checksum, detail::byte_piece... Pieces>
+Buf& append_checksummed(Buf& buf, Checksum& ck, const Pieces&... pieces) {
+  std::array<std::span<const std::byte>, sizeof...(Pieces)> sps { detail::as_byte_span(pieces)... };
+  std::size_t total { 0u };
+  for (auto sp : sps) {
+    total += sp.size();
+  }
+  auto out { buf.append_uninitialized(total).data() };
+  for (auto sp : sps) {
+    while (!sp.empty()) {
+      auto n { (std::min)(sp.size(), detail::checksum_block_size) };
+      std::memcpy(out, sp.data(), n);
+      ck.update(std::span<const std::byte>(out, n));
+      out += n;
+      sp = sp.subspan(n);
+    }
+  }
+  return buf;
+}
+
+/**
+ * @brief Compute the CRC32C of the segments of a @c shared_buffer_sequence, splitting
+ * the bytes over several threads.
+ *
+ * The bytes (not the segments) are split evenly, so a single large segment is also
+ * computed in parallel. The pieces are then joined with @c crc32c_combine. Small
+ * sequences are computed on the calling thread.
+ *
+ * @param seq Sequence of segments.
+ *
+ * @param max_threads Maximum number of threads, including the calling thread; zero
+ * (the default) for the hardware concurrency.
+ *
+ * @param min_bytes_per_thread Minimum number of bytes worth handing to a thread.
+ *
+ * @return The same value as @c crc32c(seq).
+ */
+inline std::uint32_t parallel_crc32c(const shared_buffer_sequence& seq, unsigned max_threads = 0u,
+                                     std::size_t min_bytes_per_thread = 256u * 1024u) {
+  if (max_threads == 0u) {
+    max_threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+  }
+  std::size_t total { seq.total_size() };
+  std::size_t num { (std::min)(total / (std::max)(min_bytes_per_thread, std::size_t(1u)),
+                               std::size_t(max_threads)) };
+  if (num <= 1u) {
+    return crc32c(seq);
+  }
+  std::size_t chunk { total / num };
+  std::vector<std::uint32_t> crcs(num, 0u);
+  {
+    std::vector<std::jthread> thrs;
+    thrs.reserve(num - 1u);
+    for (std::size_t i = 1u; i < num; ++i) {
+      std::size_t beg { i * chunk };
+      std::size_t end { (i == num - 1u) ? total : beg + chunk };
+      thrs.emplace_back([&seq, &crcs, i, beg, end] {
+        crcs[i] = detail::crc32c_of_range(seq.segments(), beg, end);
+      } );
+    }
+    crcs[0] = detail::crc32c_of_range(seq.segments(), 0u, chunk);
+  } // threads joined
+  std::uint32_t crc { crcs[0] };
+  for (std::size_t i = 1u; i < num; ++i) {
+    std::size_t len { (i == num - 1u) ? total - i * chunk : chunk };
+    crc = crc32c_combine(crc, crcs[i], len);
+  }
+  return crc;
+}
+
+/**
+ * @brief A @c const_shared_buffer with its CRC32C, computed once and kept alongside.
+ *
+ * The checksum can be computed by this class, or passed in when it was computed
+ * while the bytes were written (see @c append_checksummed).
+ */
+class checksummed_buffer {
+private:
+  const_shared_buffer m_buf;
+  std::uint32_t m_crc;
+
+public:
+
+/**
+ * @brief Construct from a @c const_shared_buffer, computing the CRC32C.
+ */
+  explicit checksummed_buffer(const const_shared_buffer& buf) noexcept :
+      m_buf(buf), m_crc(crc32c(buf)) { }
+
+/**
+ * @brief Construct from a @c const_shared_buffer and its already computed CRC32C.
+ *
+ * @pre The checksum covers exactly the bytes of the buffer.
+ */
+  checksummed_buffer(const const_shared_buffer& buf, const crc32c_checksum& ck) noexcept :
+      m_buf(buf), m_crc(ck.value()) { }
+
+  const const_shared_buffer& buffer() const noexcept { return m_buf; }
+  std::uint32_t checksum() const noexcept { return m_crc; }
+  const std::byte* data() const noexcept { return m_buf.data(); }
+  std::size_t size() const noexcept { return m_buf.size(); }
+
+/**
+ * @brief Recompute the CRC32C, and compare it with the kept value.
+ */
+  bool verify() const noexcept { return crc32c(m_buf) == m_crc; }
+};
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,498 @@
+/** @file
+ *
+ * @brief Compression and decompression of shared buffers and buffer sequences (LZ4
+ * and Zstandard), writing directly into uninitialized shared buffer storage.
+ *
+ * The output is written straight into a @c mutable_shared_buffer sized with the
+ * bound of the codec, without a zero fill, and then moved into a @c const_shared_buffer,
+ * so there is no intermediate @c std::vector and no extra copy of the output:
+ *
+ * @code
+ *   chops::zstd_codec zs;
+ *   chops::const_shared_buffer packed { chops::compress(zs, msg) };
+ *   // ...
+ *   chops::const_shared_buffer msg2 { chops::decompress(zs, packed, max_msg_size) };
+ * @endcode
+ *
+ * A @c shared_buffer_sequence (e.g. a header and a body) is compressed as one stream,
+ * without first flattening it, and a compressed stream received as a sequence of
+ * segments is decompressed the same way.
+ *
+ * Since the output is not copied, the storage of a compressed @c const_shared_buffer
+ * stays at the size of the codec bound (a little more than the input size) for the
+ * lifetime of the buffer. When the compressed buffer is kept for a long time and the
+ * input compresses well, an explicit copy trims it:
+ *
+ * @code
+ *   chops::const_shared_buffer trimmed(packed.data(), packed.size());
+ * @endcode
+ *
+ * The LZ4 (frame format, as written by the @c lz4 tool) and Zstandard codecs are
+ * available when their headers, @c lz4frame.h and @c zstd.h, are found (the
+ * application links with @c liblz4 or @c libzstd). The @c SHARED_BUFFER_HAS_LZ4 and
+ * @c SHARED_BUFFER_HAS_ZSTD macros are then defined. Both formats record the
+ * decompressed size in the header.
+ *
+ * Other codecs can be used with the same functions by meeting the @c compression_codec
+ * concept.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SHARED_BUFFER_COMPRESS_HPP_INCLUDED
+#define SHARED_BUFFER_COMPRESS_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <cstring> // std::memcmp
+#include <span>
+#include <vector>
+#include <array>
+#include <string>
+#include <optional>
+#include <memory> // std::unique_ptr
+#include <new> // std::bad_alloc
+#include <stdexcept> // std::runtime_error
+#include <concepts> // std::convertible_to, std::same_as
+
+#if __has_include(<lz4frame.h>) && !defined(SHARED_BUFFER_NO_LZ4)
+#include <lz4frame.h>
+#define SHARED_BUFFER_HAS_LZ4
+#endif
+
+#if __has_include(<zstd.h>) && !defined(SHARED_BUFFER_NO_ZSTD)
+#include <zstd.h>
+#define SHARED_BUFFER_HAS_ZSTD
+#endif
+
+#include "buffer/shared_buffer.hpp"
+#include "buffer/shared_buffer_sequence.hpp"
+
+namespace chops {
+
+/**
+ * @brief Exception thrown when compression or decompression fails, e.g. for corrupted
+ * input, or decompressed data larger than the allowed size.
+ */
+class compression_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief The input of a codec, a list of byte pieces processed as one stream.
+ */
+using codec_pieces = std::span<const std::span<const std::byte>>;
+
+/**
+ * @brief The interface of a codec used by @c compress and @c decompress.
+ *
+ * - @c compress_bound returns the maximum compressed size of the input.
+ * - @c compress writes the compressed stream into the output, returning the number
+ * of bytes written (the output is at least @c compress_bound bytes).
+ * - @c decompress writes the decompressed bytes into the output, returning the number
+ * of bytes written.
+ * - @c content_size returns the decompressed size recorded in the beginning of a
+ * compressed stream, if there is one.
+ *
+ * Errors are reported by throwing @c compression_error.
+ */
+template <typename C>
+concept compression_codec = requires (const C& c, codec_pieces src, std::span<std::byte> dst,
+                                      std::span<const std::byte> hdr) {
+  { c.compress_bound(src) } -> std::convertible_to<std::size_t>;
+  { c.compress(src, dst) } -> std::convertible_to<std::size_t>;
+  { c.decompress(src, dst) } -> std::convertible_to<std::size_t>;
+  { c.content_size(hdr) } -> std::same_as<std::optional<std::size_t>>;
+};
+
+namespace detail {
+
+// output buffers are resized without a zero fill, since the codec overwrites them
+using codec_buffer = basic_mutable_shared_buffer<default_init_allocator<std::byte>>;
+
+inline std::size_t pieces_size(codec_pieces src) noexcept {
+  std::size_t sz { 0u };
+  for (auto p : src) {
+    sz += p.size();
+  }
+  return sz;
+}
+
+inline std::vector<std::span<const std::byte>> pieces_of(const shared_buffer_sequence& seq) {
+  std::vector<std::span<const std::byte>> pieces;
+  pieces.reserve(seq.size());
+  for (const auto& seg : seq) {
+    pieces.emplace_back(seg.data(), seg.size());
+  }
+  return pieces;
+}
+
+template <compression_codec Codec, typename Buf>
+std::size_t compress_pieces(const Codec& codec, codec_pieces src, Buf& dst) {
+  auto old_sz { dst.size() };
+  auto out { dst.append_uninitialized(codec.compress_bound(src)) };
+  std::size_t n { 0u };
+  try {
+    n = codec.compress(src, out);
+  }
+  catch (...) {
+    dst.resize_uninitialized(old_sz);
+    throw;
+  }
+  dst.resize_uninitialized(old_sz + n);
+  return n;
+}
+
+template <compression_codec Codec>
+const_shared_buffer compress_to_const(const Codec& codec, codec_pieces src) {
+  codec_buffer buf;
+  compress_pieces(codec, src, buf);
+  return const_shared_buffer(std::move(buf));
+}
+
+template <compression_codec Codec>
+const_shared_buffer decompress_to_const(const Codec& codec, codec_pieces src, std::size_t max_size) {
+  auto recorded { src.empty() ? std::nullopt : codec.content_size(src.front()) };
+  if (!recorded && max_size == 0u) {
+    throw compression_error("decompressed size is not recorded and no maximum size is given");
+  }
+  if (recorded && max_size != 0u && *recorded > max_size) {
+    throw compression_error("decompressed size exceeds the maximum size");
+  }
+  codec_buffer buf;
+  auto out { buf.resize_uninitialized(recorded ? *recorded : max_size) };
+  buf.resize_uninitialized(codec.decompress(src, out));
+  return const_shared_buffer(std::move(buf));
+}
+
+} // end detail namespace
+
+/**
+ * @brief Compress bytes, appending the compressed stream to a mutable buffer.
+ *
+ * The space for the codec bound is appended (without a zero fill when the buffer
+ * allocator is a @c default_init_allocator), compressed into, then trimmed.
+ *
+ * @param codec Codec to use, such as @c lz4_codec or @c zstd_codec.
+ *
+ * @param src Bytes to compress, a @c std::span of @c std::byte or a buffer with
+ * @c data and @c size methods, such as a @c const_shared_buffer.
+ *
+ * @param dst Buffer to append to, typically a @c mutable_shared_buffer.
+ *
+ * @return Number of compressed bytes appended.
+ *
+ * @throw compression_error If the codec fails; @c dst is left unchanged.
+ */
+template <compression_codec Codec, detail::byte_piece P, typename Buf>
+std::size_t compress_append(const Codec& codec, const P& src, Buf& dst) {
+  std::array<std::span<const std::byte>, 1u> pieces { detail::as_byte_span(src) };
+  return detail::compress_pieces(codec, pieces, dst);
+}
+
+/**
+ * @brief Compress the segments of a @c shared_buffer_sequence as one stream, appending
+ * the compressed stream to a mutable buffer.
+ */
+template <compression_codec Codec, typename Buf>
+std::size_t compress_append(const Codec& codec, const shared_buffer_sequence& src, Buf& dst) {
+  auto pieces { detail::pieces_of(src) };
+  return detail::compress_pieces(codec, pieces, dst);
+}
+
+/**
+ * @brief Compress bytes into a @c const_shared_buffer.
+ *
+ * The storage of the result is the size of the codec bound, see the file
+ * documentation.
+ *
+ * @param codec Codec to use, such as @c lz4_codec or @c zstd_codec.
+ *
+ * @param src Bytes to compress, a @c std::span of @c std::byte or a buffer with
+ * @c data and @c size methods.
+ *
+ * @throw compression_error If the codec fails.
+ */
+template <compression_codec Codec, detail::byte_piece P>
+const_shared_buffer compress(const Codec& codec, const P& src) {
+  std::array<std::span<const std::byte>, 1u> pieces { detail::as_byte_span(src) };
+  return detail::compress_to_const(codec, pieces);
+}
+
+/**
+ * @brief Compress the segments of a @c shared_buffer_sequence as one stream into a
+ * @c const_shared_buffer.
+ */
+template <compression_codec Codec>
+const_shared_buffer compress(const Codec& codec, const shared_buffer_sequence& src) {
+  auto pieces { detail::pieces_of(src) };
+  return detail::compress_to_const(codec, pieces);
+}
+
+/**
+ * @brief Decompress a compressed stream into a @c const_shared_buffer.
+ *
+ * The output is sized from the decompressed size recorded in the stream, or from
+ * @c max_size when the size is not recorded.
+ *
+ * @param codec Codec to use.
+ *
+ * @param src Compressed bytes.
+ *
+ * @param max_size Maximum decompressed size, which protects against small inputs that
+ * decompress into huge outputs; zero (the default) for no limit, in which case the
+ * size must be recorded in the stream. When the size is not recorded (or not found in
+ * the first segment of a sequence), @c max_size bytes are allocated up front and kept
+ * as the storage of the result, so it should not be much larger than the expected size.
+ *
+ * @throw compression_error If the input is corrupted, or the decompressed size is
+ * greater than @c max_size (or is unknown and no @c max_size is given).
+ */
+template <compression_codec Codec, detail::byte_piece P>
+const_shared_buffer decompress(const Codec& codec, const P& src, std::size_t max_size = 0u) {
+  std::array<std::span<const std::byte>, 1u> pieces { detail::as_byte_span(src) };
+  return detail::decompress_to_const(codec, pieces, max_size);
+}
+
+/**
+ * @brief Decompress a compressed stream received as the segments of a
+ * @c shared_buffer_sequence, without first flattening it.
+ *
+ * The recorded decompressed size is read from the first segment; if the first
+ * segment is too short to hold the stream header, @c max_size is used.
+ */
+template <compression_codec Codec>
+const_shared_buffer decompress(const Codec& codec, const shared_buffer_sequence& src,
+                               std::size_t max_size = 0u) {
+  auto pieces { detail::pieces_of(src) };
+  return detail::decompress_to_const(codec, pieces, max_size);
+}
+
+#if defined(SHARED_BUFFER_HAS_LZ4)
+
+/**
+ * @brief LZ4 codec, using the LZ4 frame format with the content size recorded.
+ */
+class lz4_codec {
+private:
+  LZ4F_preferences_t m_prefs;
+
+  static std::size_t check(std::size_t code) {
+    if (LZ4F_isError(code)) {
+      throw compression_error(std::string("lz4: ") + LZ4F_getErrorName(code));
+    }
+    return code;
+  }
+
+  struct cctx_deleter {
+    void operator()(LZ4F_cctx* p) const noexcept { LZ4F_freeCompressionContext(p); }
+  };
+  struct dctx_deleter {
+    void operator()(LZ4F_dctx* p) const noexcept { LZ4F_freeDecompressionContext(p); }
+  };
+
+  static std::unique_ptr<LZ4F_dctx, dctx_deleter> make_dctx() {
+    LZ4F_dctx* p { nullptr };
+    check(LZ4F_createDecompressionContext(&p, LZ4F_VERSION));
+    return std::unique_ptr<LZ4F_dctx, dctx_deleter>(p);
+  }
+
+public:
+
+/**
+ * @brief Construct with a compression level, zero (the default) for the fast LZ4
+ * compression, and higher values for LZ4 HC.
+ */
+  explicit lz4_codec(int level = 0) noexcept : m_prefs() {
+    m_prefs.compressionLevel = level;
+  }
+
+  std::size_t compress_bound(codec_pieces src) const noexcept {
+    // each update may flush previously buffered bytes, so the bounds are summed
+    std::size_t sz { LZ4F_HEADER_SIZE_MAX + LZ4F_compressBound(0u, &m_prefs) };
+    for (auto p : src) {
+      sz += LZ4F_compressBound(p.size(), &m_prefs);
+    }
+    return sz;
+  }
+
+  std::size_t compress(codec_pieces src, std::span<std::byte> dst) const {
+    auto prefs { m_prefs };
+    prefs.frameInfo.contentSize = detail::pieces_size(src);
+    LZ4F_cctx* p { nullptr };
+    check(LZ4F_createCompressionContext(&p, LZ4F_VERSION));
+    std::unique_ptr<LZ4F_cctx, cctx_deleter> cctx(p);
+    std::size_t pos { check(LZ4F_compressBegin(p, dst.data(), dst.size(), &prefs)) };
+    for (auto piece : src) {
+      pos += check(LZ4F_compressUpdate(p, dst.data() + pos, dst.size() - pos,
+                                       piece.data(), piece.size(), nullptr));
+    }
+    pos += check(LZ4F_compressEnd(p, dst.data() + pos, dst.size() - pos, nullptr));
+    return pos;
+  }
+
+  std::optional<std::size_t> content_size(std::span<const std::byte> hdr) const {
+    auto dctx { make_dctx() };
+    LZ4F_frameInfo_t info { };
+    std::size_t sz { hdr.size() };
+    if (LZ4F_isError(LZ4F_getFrameInfo(dctx.get(), &info, hdr.data(), &sz))) {
+      return std::nullopt;
+    }
+    if (info.contentSize != 0u) {
+      return static_cast<std::size_t>(info.contentSize);
+    }
+    // a zero size is not recorded, but an empty frame has the end mark right after the
+    // header; otherwise the size is unknown
+    constexpr std::byte end_mark[4] { };
+    if (hdr.size() - sz >= sizeof(end_mark) && std::memcmp(hdr.data() + sz, end_mark, sizeof(end_mark)) == 0) {
+      return 0u;
+    }
+    return std::nullopt;
+  }
+
+  std::size_t decompress(codec_pieces src, std::span<std::byte> dst) const {
+    auto dctx { make_dctx() };
+    std::size_t pos { 0u };
+    for (auto piece : src) {
+      const std::byte* in { piece.data() };
+      std::size_t left { piece.size() };
+      while (left > 0u) {
+        std::size_t out_sz { dst.size() - pos };
+        std::size_t in_sz { left };
+        auto hint { check(LZ4F_decompress(dctx.get(), dst.data() + pos, &out_sz, in, &in_sz, nullptr)) };
+        pos += out_sz;
+        in += in_sz;
+        left -= in_sz;
+        if (hint == 0u) {
+          return pos; // end of frame
+        }
+        if (in_sz == 0u && out_sz == 0u) {
+          throw compression_error("lz4: decompressed data larger than the output");
+        }
+      }
+    }
+    throw compression_error("lz4: incomplete frame");
+  }
+};
+
+#endif
+
+#if defined(SHARED_BUFFER_HAS_ZSTD)
+
+/**
+ * @brief Zstandard codec.
+ *
+ * A single piece is compressed and decompressed with the one shot functions, and
+ * multiple pieces (a buffer sequence) with the streaming functions.
+ */
+class zstd_codec {
+private:
+  int m_level;
+
+  static std::size_t check(std::size_t code) {
+    if (ZSTD_isError(code)) {
+      throw compression_error(std::string("zstd: ") + ZSTD_getErrorName(code));
+    }
+    return code;
+  }
+
+  struct cctx_deleter {
+    void operator()(ZSTD_CCtx* p) const noexcept { ZSTD_freeCCtx(p); }
+  };
+  struct dctx_deleter {
+    void operator()(ZSTD_DCtx* p) const noexcept { ZSTD_freeDCtx(p); }
+  };
+
+public:
+
+/**
+ * @brief Construct with a compression level, 3 (the Zstandard default) if not given.
+ */
+  explicit zstd_codec(int level = 3) noexcept : m_level(level) { }
+
+  std::size_t compress_bound(codec_pieces src) const noexcept {
+    return ZSTD_compressBound(detail::pieces_size(src));
+  }
+
+  std::size_t compress(codec_pieces src, std::span<std::byte> dst) const {
+    if (src.size() == 1u) {
+      return check(ZSTD_compress(dst.data(), dst.size(), src[0].data(), src[0].size(), m_level));
+    }
+    std::unique_ptr<ZSTD_CCtx, cctx_deleter> cctx(ZSTD_createCCtx());
+    if (!cctx) {
+      throw std::bad_alloc();
+    }
+    check(ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, m_level));
+    check(ZSTD_CCtx_setPledgedSrcSize(cctx.get(), detail::pieces_size(src)));
+    ZSTD_outBuffer out { dst.data(), dst.size(), 0u };
+    for (auto piece : src) {
+      ZSTD_inBuffer in { piece.data(), piece.size(), 0u };
+      while (in.pos < in.size) {
+        check(ZSTD_compressStream2(cctx.get(), &out, &in, ZSTD_e_continue));
+        if (out.pos == out.size && in.pos < in.size) {
+          throw compression_error("zstd: compressed data larger than the output");
+        }
+      }
+    }
+    ZSTD_inBuffer none { nullptr, 0u, 0u };
+    while (check(ZSTD_compressStream2(cctx.get(), &out, &none, ZSTD_e_end)) != 0u) {
+      if (out.pos == out.size) {
+        throw compression_error("zstd: compressed data larger than the output");
+      }
+    }
+    return out.pos;
+  }
+
+  std::optional<std::size_t> content_size(std::span<const std::byte> hdr) const noexcept {
+    auto sz { ZSTD_getFrameContentSize(hdr.data(), hdr.size()) };
+    if (sz == ZSTD_CONTENTSIZE_UNKNOWN || sz == ZSTD_CONTENTSIZE_ERROR) {
+      return std::nullopt;
+    }
+    return static_cast<std::size_t>(sz);
+  }
+
+  std::size_t decompress(codec_pieces src, std::span<std::byte> dst) const {
+    if (src.size() == 1u) {
+      return check(ZSTD_decompress(dst.data(), dst.size(), src[0].data(), src[0].size()));
+    }
+    std::unique_ptr<ZSTD_DCtx, dctx_deleter> dctx(ZSTD_createDCtx());
+    if (!dctx) {
+      throw std::bad_alloc();
+    }
+    ZSTD_outBuffer out { dst.data(), dst.size(), 0u };
+    std::size_t hint { 1u };
+    for (auto piece : src) {
+      ZSTD_inBuffer in { piece.data(), piece.size(), 0u };
+      while (in.pos < in.size) {
+        auto prev_in { in.pos };
+        auto prev_out { out.pos };
+        hint = check(ZSTD_decompressStream(dctx.get(), &out, &in));
+        if (in.pos == prev_in && out.pos == prev_out) {
+          throw compression_error("zstd: decompressed data larger than the output");
+        }
+      }
+    }
+    while (hint != 0u) { // flush what is still buffered
+      ZSTD_inBuffer none { nullptr, 0u, 0u };
+      auto prev_out { out.pos };
+      hint = check(ZSTD_decompressStream(dctx.get(), &out, &none));
+      if (hint != 0u && out.pos == prev_out) {
+        throw compression_error("zstd: incomplete or too large frame");
+      }
+    }
+    return out.pos;
+  }
+};
+
+#endif
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,311 @@
+/** @file
+ *
+ * @brief A recycling memory pool for @c mutable_shared_buffer and
+ * @c const_shared_buffer storage.
+ *
+ * Steady state network IO repeatedly allocates and frees buffers of nearly the same
+ * sizes. The @c shared_buffer_pool keeps freed memory blocks in power of two size
+ * classes and hands them out again, instead of returning them to the global heap.
+ *
+ * The pool is a @c std::pmr::memory_resource, and the buffers it creates are
+ * @c chops::pmr::mutable_shared_buffer objects, so both the reference count block
+ * and the byte storage come from the pool. When the last reference goes away (which
+ * may be a @c const_shared_buffer that was moved from the @c mutable_shared_buffer),
+ * the memory goes back to the pool.
+ *
+ * Each thread has a cache of free blocks for each pool, so allocating and freeing
+ * does not need any synchronization in the common case. When a thread cache for a
+ * size class is full, the blocks are moved to a lock-free global list for that
+ * size class, where any thread can pick them up. This allows buffers to be freed
+ * on a different thread than the one that allocated them (e.g. an IO completion
+ * thread) without the blocks piling up.
+ *
+ * @note As with any @c std::pmr::memory_resource, the pool must outlive all buffers
+ * that have been created from it.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SHARED_BUFFER_POOL_HPP_INCLUDED
+#define SHARED_BUFFER_POOL_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t, std::max_align_t
+#include <cstdint> // std::uint64_t
+#include <memory> // std::shared_ptr, std::weak_ptr, std::unique_ptr
+#include <memory_resource>
+#include <atomic>
+#include <vector> // std::vector, std::erase_if
+#include <new> // operator new, std::align_val_t
+#include <bit> // std::bit_width
+#include <span>
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+namespace detail {
+
+struct pool_free_node {
+  pool_free_node* next;
+};
+
+// shared between the pool and the thread caches, so that a thread exiting after
+// the pool is destroyed can tell that the pool is gone
+struct pool_state {
+
+  static constexpr std::size_t min_block_shift = 5u; // 32 byte smallest size class
+
+  std::uint64_t id;
+  std::size_t num_classes;
+  std::size_t cache_limit;
+  std::unique_ptr<std::atomic<pool_free_node*>[]> global;
+
+  pool_state(std::size_t max_block_size, std::size_t thread_cache_limit) :
+      id(next_id()),
+      num_classes(class_index(max_block_size) + 1u),
+      cache_limit(thread_cache_limit),
+      global(std::make_unique<std::atomic<pool_free_node*>[]>(num_classes)) { }
+
+  pool_state(const pool_state&) = delete;
+  pool_state& operator=(const pool_state&) = delete;
+
+  ~pool_state() {
+    for (std::size_t cls = 0u; cls < num_classes; ++cls) {
+      free_chain(global[cls].exchange(nullptr), cls);
+    }
+  }
+
+  static std::uint64_t next_id() noexcept {
+    static std::atomic<std::uint64_t> counter { 0u };
+    return ++counter;
+  }
+
+  static constexpr std::size_t class_size(std::size_t cls) noexcept {
+    return std::size_t(1u) << (cls + min_block_shift);
+  }
+
+  static constexpr std::size_t class_index(std::size_t bytes) noexcept {
+    auto shift = static_cast<std::size_t>(std::bit_width(bytes > 1u ? bytes - 1u : 1u));
+    return shift > min_block_shift ? shift - min_block_shift : 0u;
+  }
+
+  static void free_chain(pool_free_node* head, std::size_t cls) noexcept {
+    while (head) {
+      auto nxt = head->next;
+      ::operator delete(static_cast<void*>(head), class_size(cls));
+      head = nxt;
+    }
+  }
+
+  // pushing a chain is ABA safe; popping is always done by taking the whole list
+  void push_global(pool_free_node* head, pool_free_node* tail, std::size_t cls) noexcept {
+    auto& top = global[cls];
+    tail->next = top.load(std::memory_order_relaxed);
+    while (!top.compare_exchange_weak(tail->next, head,
+                                      std::memory_order_release, std::memory_order_relaxed)) { }
+  }
+
+  pool_free_node* take_global(std::size_t cls) noexcept {
+    return global[cls].exchange(nullptr, std::memory_order_acquire);
+  }
+};
+
+struct pool_thread_cache {
+
+  struct free_list {
+    pool_free_node* head { nullptr };
+    std::size_t count { 0u };
+  };
+
+  struct entry {
+    std::uint64_t id;
+    std::weak_ptr<pool_state> state;
+    std::vector<free_list> lists;
+  };
+
+  std::vector<entry> entries;
+
+  pool_thread_cache() = default;
+  pool_thread_cache(const pool_thread_cache&) = delete;
+  pool_thread_cache& operator=(const pool_thread_cache&) = delete;
+
+  ~pool_thread_cache() {
+    for (auto& e : entries) {
+      flush(e);
+    }
+  }
+
+  // blocks are given back to the pool if it still exists, otherwise freed
+  static void flush(entry& e) noexcept {
+    auto st = e.state.lock();
+    for (std::size_t cls = 0u; cls < e.lists.size(); ++cls) {
+      auto& lst = e.lists[cls];
+      if (!lst.head) {
+        continue;
+      }
+      if (st) {
+        auto tail = lst.head;
+        while (tail->next) {
+          tail = tail->next;
+        }
+        st->push_global(lst.head, tail, cls);
+      }
+      else {
+        pool_state::free_chain(lst.head, cls);
+      }
+      lst = free_list { };
+    }
+  }
+
+  entry& find(const std::shared_ptr<pool_state>& st) {
+    for (auto& e : entries) {
+      if (e.id == st->id) {
+        return e;
+      }
+    }
+    std::erase_if(entries, [] (entry& e) {
+      if (e.state.expired()) {
+        flush(e);
+        return true;
+      }
+      return false;
+    } );
+    entries.push_back(entry { st->id, st, std::vector<free_list>(st->num_classes) });
+    return entries.back();
+  }
+};
+
+inline pool_thread_cache& thread_cache() {
+  thread_local pool_thread_cache cache;
+  return cache;
+}
+
+} // end detail namespace
+
+/**
+ * @brief A @c std::pmr::memory_resource that recycles memory blocks in size classes,
+ * with per-thread caches and lock-free global overflow lists, along with convenience
+ * methods to create shared buffers using the pool.
+ *
+ * Requests larger than the maximum block size, or with an alignment greater than
+ * @c alignof(std::max_align_t), are passed directly to global @c operator @c new
+ * and @c operator @c delete.
+ *
+ * Memory held in the pool is released when the pool is destroyed, or (for blocks
+ * held in a thread cache) when the thread exits.
+ */
+class shared_buffer_pool : public std::pmr::memory_resource {
+public:
+  using size_type = typename pmr::mutable_shared_buffer::size_type;
+
+  static constexpr std::size_t default_max_block_size = 64u * 1024u;
+  static constexpr std::size_t default_thread_cache_limit = 64u;
+
+private:
+  std::shared_ptr<detail::pool_state> m_state;
+  std::size_t m_max_block_size;
+
+public:
+
+/**
+ * @brief Construct a @c shared_buffer_pool.
+ *
+ * @param max_block_size Largest block size that is recycled, rounded up to a power
+ * of two.
+ *
+ * @param thread_cache_limit Maximum number of free blocks per size class kept in
+ * a thread cache before they are moved to the global list.
+ */
+  explicit shared_buffer_pool(std::size_t max_block_size = default_max_block_size,
+                              std::size_t thread_cache_limit = default_thread_cache_limit) :
+      m_state(std::make_shared<detail::pool_state>(max_block_size, thread_cache_limit)),
+      m_max_block_size(detail::pool_state::class_size(m_state->num_classes - 1u)) { }
+
+  shared_buffer_pool(const shared_buffer_pool&) = delete;
+  shared_buffer_pool& operator=(const shared_buffer_pool&) = delete;
+
+/**
+ * @brief Create a @c mutable_shared_buffer of the given size, with bytes set to zero,
+ * using memory from the pool.
+ *
+ * @param sz Size of the buffer.
+ */
+  pmr::mutable_shared_buffer make_buffer(size_type sz) {
+    return pmr::mutable_shared_buffer(sz, this);
+  }
+
+/**
+ * @brief Create a @c mutable_shared_buffer by copying bytes, using memory from the pool.
+ *
+ * @param sp @c std::byte span pointing to the data to be copied.
+ */
+  template <std::size_t Ext>
+  pmr::mutable_shared_buffer make_buffer(std::span<const std::byte, Ext> sp) {
+    return pmr::mutable_shared_buffer(sp, this);
+  }
+
+/**
+ * @brief Return the largest block size that is recycled by the pool.
+ */
+  std::size_t max_block_size() const noexcept { return m_max_block_size; }
+
+private:
+
+  void* do_allocate(std::size_t bytes, std::size_t align) override {
+    if (bytes > m_max_block_size || align > alignof(std::max_align_t)) {
+      return ::operator new(bytes, std::align_val_t{align});
+    }
+    auto cls = detail::pool_state::class_index(bytes);
+    auto& lst = detail::thread_cache().find(m_state).lists[cls];
+    if (!lst.head) {
+      lst.head = m_state->take_global(cls);
+      for (auto p = lst.head; p; p = p->next) {
+        ++lst.count;
+      }
+      if (!lst.head) {
+        return ::operator new(detail::pool_state::class_size(cls));
+      }
+    }
+    auto node = lst.head;
+    lst.head = node->next;
+    --lst.count;
+    return node;
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+    if (bytes > m_max_block_size || align > alignof(std::max_align_t)) {
+      ::operator delete(p, bytes, std::align_val_t{align});
+      return;
+    }
+    auto cls = detail::pool_state::class_index(bytes);
+    auto& lst = detail::thread_cache().find(m_state).lists[cls];
+    if (lst.head && lst.count >= m_state->cache_limit) {
+      auto tail = lst.head;
+      while (tail->next) {
+        tail = tail->next;
+      }
+      m_state->push_global(lst.head, tail, cls);
+      lst = detail::pool_thread_cache::free_list { };
+    }
+    auto node = static_cast<detail::pool_free_node*>(p);
+    node->next = lst.head;
+    lst.head = node;
+    ++lst.count;
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+};
+
+} // end namespace
+
+#endif
+
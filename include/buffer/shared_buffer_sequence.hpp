@@ -0,0 +1,323 @@
+/** @file
+ *
+ * @brief An ordered sequence of @c const_shared_buffer segments, for scatter / gather
+ * (vectored) IO.
+ *
+ * Outgoing messages are often built from a header, a body, and a trailer, each
+ * created in a different place. Instead of appending all of them into one
+ * @c mutable_shared_buffer (copying every byte), the segments can be kept in a
+ * @c shared_buffer_sequence and written with one gather write (e.g. @c writev or
+ * @c sendmsg). Each segment keeps its own bytes alive through its reference count.
+ *
+ * The first few segments are stored inside the @c shared_buffer_sequence object, so
+ * a typical message of one to four segments does not need a heap allocation for the
+ * sequence itself.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SHARED_BUFFER_SEQUENCE_HPP_INCLUDED
+#define SHARED_BUFFER_SEQUENCE_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <vector>
+#include <span>
+#include <initializer_list>
+#include <new> // placement new, std::launder
+#include <utility> // std::move, std::forward
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+/**
+ * @brief An ordered sequence of @c const_shared_buffer segments, with inline storage
+ * for a small number of segments.
+ *
+ * Segments are appended to the end of the sequence, and the sequence can be iterated
+ * in order. The total number of bytes over all segments is tracked as segments are
+ * added.
+ *
+ * The @c fill_io_vectors method fills in an array of IO vector entries (such as the
+ * POSIX @c iovec structure) for use with gather writes, without any dependency on
+ * platform headers.
+ *
+ * A @c std::byte pointer obtained from any segment stays valid for the lifetime of
+ * that segment (or any copy of it), even if the @c shared_buffer_sequence is modified
+ * or moved.
+ *
+ */
+class shared_buffer_sequence {
+public:
+  using value_type = const_shared_buffer;
+  using size_type = std::size_t;
+  using const_iterator = const const_shared_buffer*;
+  using iterator = const_iterator;
+
+  static constexpr size_type inline_capacity = 4u;
+
+private:
+  alignas(const_shared_buffer) std::byte m_inline[inline_capacity * sizeof(const_shared_buffer)];
+  std::vector<const_shared_buffer> m_heap;
+  size_type m_inline_count;
+  size_type m_total;
+  bool m_on_heap;
+
+private:
+
+  const_shared_buffer* inline_segs() noexcept {
+    return std::launder(reinterpret_cast<const_shared_buffer*>(m_inline));
+  }
+  const const_shared_buffer* inline_segs() const noexcept {
+    return std::launder(reinterpret_cast<const const_shared_buffer*>(m_inline));
+  }
+
+  void move_to_heap() {
+    m_heap.reserve(2u * inline_capacity);
+    for (size_type i = 0u; i < m_inline_count; ++i) {
+      m_heap.push_back(std::move(inline_segs()[i]));
+    }
+    destroy_inline();
+    m_on_heap = true;
+  }
+
+  void destroy_inline() noexcept {
+    for (size_type i = 0u; i < m_inline_count; ++i) {
+      inline_segs()[i].~const_shared_buffer();
+    }
+    m_inline_count = 0u;
+  }
+
+  void move_from(shared_buffer_sequence& rhs) noexcept {
+    if (rhs.m_on_heap) {
+      m_heap = std::move(rhs.m_heap);
+      m_on_heap = true;
+    }
+    else {
+      for (size_type i = 0u; i < rhs.m_inline_count; ++i) {
+        ::new (static_cast<void*>(inline_segs() + i)) const_shared_buffer(std::move(rhs.inline_segs()[i]));
+      }
+      m_inline_count = rhs.m_inline_count;
+    }
+    m_total = rhs.m_total;
+    rhs.clear();
+  }
+
+public:
+
+/**
+ * @brief Default construct an empty @c shared_buffer_sequence.
+ */
+  shared_buffer_sequence() noexcept : m_heap(), m_inline_count(0u), m_total(0u), m_on_heap(false) { }
+
+/**
+ * @brief Construct a @c shared_buffer_sequence from a list of segments.
+ *
+ * @param segs Segments to be copied into the sequence, in order.
+ */
+  shared_buffer_sequence(std::initializer_list<const_shared_buffer> segs) : shared_buffer_sequence() {
+    for (const auto& seg : segs) {
+      push_back(seg);
+    }
+  }
+
+  shared_buffer_sequence(const shared_buffer_sequence& rhs) : shared_buffer_sequence() {
+    for (const auto& seg : rhs) {
+      push_back(seg);
+    }
+  }
+
+  shared_buffer_sequence(shared_buffer_sequence&& rhs) noexcept : shared_buffer_sequence() {
+    move_from(rhs);
+  }
+
+  shared_buffer_sequence& operator=(const shared_buffer_sequence& rhs) {
+    if (this != &rhs) {
+      clear();
+      for (const auto& seg : rhs) {
+        push_back(seg);
+      }
+    }
+    return *this;
+  }
+
+  shared_buffer_sequence& operator=(shared_buffer_sequence&& rhs) noexcept {
+    if (this != &rhs) {
+      clear();
+      move_from(rhs);
+    }
+    return *this;
+  }
+
+  ~shared_buffer_sequence() { destroy_inline(); }
+
+/**
+ * @brief Append a segment to the end of the sequence, constructing it in place.
+ *
+ * @param args Arguments forwarded to a @c const_shared_buffer constructor.
+ *
+ * @return Reference to the new segment.
+ */
+  template <typename... Args>
+  const const_shared_buffer& emplace_back(Args&&... args) {
+    if (!m_on_heap && m_inline_count < inline_capacity) {
+      auto seg = ::new (static_cast<void*>(inline_segs() + m_inline_count))
+                   const_shared_buffer(std::forward<Args>(args)...);
+      ++m_inline_count;
+      m_total += seg->size();
+      return *seg;
+    }
+    if (!m_on_heap) {
+      // the arguments may refer to an inline segment, so construct before moving them
+      const_shared_buffer tmp(std::forward<Args>(args)...);
+      move_to_heap();
+      const auto& seg = m_heap.emplace_back(std::move(tmp));
+      m_total += seg.size();
+      return seg;
+    }
+    const auto& seg = m_heap.emplace_back(std::forward<Args>(args)...);
+    m_total += seg.size();
+    return seg;
+  }
+
+/**
+ * @brief Append a segment to the end of the sequence.
+ *
+ * No bytes are copied, the segment shares the reference count with the
+ * @c const_shared_buffer passed in.
+ *
+ * @param seg @c const_shared_buffer segment.
+ *
+ * @return Reference to @c this (to allow method chaining).
+ */
+  shared_buffer_sequence& push_back(const const_shared_buffer& seg) {
+    emplace_back(seg);
+    return *this;
+  }
+
+/**
+ * @brief Append a segment to the end of the sequence by moving.
+ *
+ * @param seg @c const_shared_buffer segment to be moved from.
+ *
+ * @return Reference to @c this (to allow method chaining).
+ */
+  shared_buffer_sequence& push_back(const_shared_buffer&& seg) {
+    emplace_back(std::move(seg));
+    return *this;
+  }
+
+/**
+ * @brief Append all of the segments of another @c shared_buffer_sequence.
+ *
+ * @param rhs @c shared_buffer_sequence to append from.
+ *
+ * @return Reference to @c this (to allow method chaining).
+ */
+  shared_buffer_sequence& append(const shared_buffer_sequence& rhs) {
+    for (size_type i = 0u, n = rhs.size(); i < n; ++i) { // allows appending to itself
+      const_shared_buffer seg(rhs[i]);
+      push_back(std::move(seg));
+    }
+    return *this;
+  }
+
+/**
+ * @brief Remove all segments.
+ */
+  void clear() noexcept {
+    destroy_inline();
+    m_heap.clear();
+    m_on_heap = false;
+    m_total = 0u;
+  }
+
+/**
+ * @brief Return the number of segments.
+ */
+  size_type size() const noexcept { return m_on_heap ? m_heap.size() : m_inline_count; }
+
+/**
+ * @brief Query to see if there are no segments.
+ */
+  bool empty() const noexcept { return size() == 0u; }
+
+/**
+ * @brief Return the total number of bytes over all segments.
+ */
+  size_type total_size() const noexcept { return m_total; }
+
+/**
+ * @brief Return the segments as a contiguous @c std::span.
+ *
+ * The @c std::span is invalidated when the sequence is modified.
+ */
+  std::span<const const_shared_buffer> segments() const noexcept {
+    return { m_on_heap ? m_heap.data() : inline_segs(), size() };
+  }
+
+  const_iterator begin() const noexcept { return segments().data(); }
+  const_iterator end() const noexcept { return segments().data() + size(); }
+
+/**
+ * @brief Return a segment by index.
+ *
+ * @pre @c idx must be less than @c size().
+ */
+  const const_shared_buffer& operator[](size_type idx) const noexcept { return segments()[idx]; }
+
+/**
+ * @brief Fill in IO vector entries for a gather write, one per segment.
+ *
+ * The IO vector type must have an @c iov_base (pointer) member and an @c iov_len
+ * (length) member, as the POSIX @c iovec structure has. Empty segments are skipped.
+ *
+ * @param iovs Span of IO vector entries to fill in.
+ *
+ * @return Number of entries filled in; if less than the number of non-empty
+ * segments, the remaining segments must be written in a subsequent call.
+ */
+  template <typename IoVec>
+  size_type fill_io_vectors(std::span<IoVec> iovs) const noexcept {
+    size_type cnt { 0u };
+    for (const auto& seg : *this) {
+      if (cnt == iovs.size()) {
+        break;
+      }
+      if (seg.empty()) {
+        continue;
+      }
+      iovs[cnt].iov_base = const_cast<std::byte*>(seg.data()); // iovec is not const correct
+      iovs[cnt].iov_len = seg.size();
+      ++cnt;
+    }
+    return cnt;
+  }
+
+/**
+ * @brief Copy all of the segments into one contiguous @c const_shared_buffer.
+ *
+ * This is useful when a destination requires a single buffer. A single segment
+ * sequence returns that segment without copying.
+ */
+  const_shared_buffer flatten() const {
+    if (size() == 1u) {
+      return (*this)[0];
+    }
+    mutable_shared_buffer buf;
+    buf.append_all(*this);
+    return const_shared_buffer(std::move(buf));
+  }
+
+};
+
+} // end namespace
+
+#endif
+
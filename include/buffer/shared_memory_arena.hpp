@@ -0,0 +1,611 @@
+/** @file
+ *
+ * @brief A shared memory arena for passing @c const_shared_buffer contents between
+ * processes on the same host without copying.
+ *
+ * The arena is a POSIX shared memory object (@c shm_open, or @c memfd_create on Linux)
+ * divided into fixed size slots. A producer writes a message into a slot and publishes
+ * it as a @c const_shared_buffer. A small @c shared_memory_handle (offset, length, and
+ * generation) is then sent to other processes, for example over a UNIX socket, and each
+ * of them gets a @c const_shared_buffer referring to the same bytes:
+ *
+ * @code
+ *   // feed handler
+ *   auto arena { chops::shared_memory_arena::create("/feed", 1024u, 64u * 1024u) };
+ *   auto buf { arena.copy(msg_bytes) };        // or allocate, write, and publish
+ *   send(sock, arena.handle(buf));             // buf is kept until the reader is done
+ *
+ *   // strategy process
+ *   auto arena { chops::shared_memory_arena::open("/feed") };
+ *   auto view { arena.view(hdl) };             // std::optional<const_shared_buffer>
+ * @endcode
+ *
+ * Each process attached to the arena (up to @c max_processes) holds a reference bit in
+ * the slots it uses, while copies within a process use the usual (process local)
+ * reference count. A slot is free for reuse when no process holds it, and its
+ * generation changes when it is reused, so a stale handle is detected by @c view.
+ *
+ * If a process crashes, the references it held are released by @c reclaim, or when
+ * another process attaches in its place. A crashed process is detected through an
+ * open file description lock that the kernel releases when the process exits, so there
+ * is no dependency on process ids (which can be reused).
+ *
+ * Failures are reported by throwing @c std::system_error with the operating system
+ * error code, in the same way as @c map_file.
+ *
+ * @note POSIX only, and the crash detection needs open file description locks
+ * (@c F_OFD_SETLK, Linux 3.15 or later). Otherwise traditional record locks are used,
+ * which have the same crash detection but cannot tell apart two arena objects for the
+ * same shared memory object in one process, so a process must then attach only once.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SHARED_MEMORY_ARENA_HPP_INCLUDED
+#define SHARED_MEMORY_ARENA_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <cstdint> // std::uint32_t, std::uint64_t, std::int32_t
+#include <cstring> // std::memcpy
+#include <atomic>
+#include <memory> // std::shared_ptr, std::make_shared, std::get_deleter
+#include <mutex>
+#include <vector>
+#include <string>
+#include <optional>
+#include <span>
+#include <new> // std::bad_alloc, placement new
+#include <stdexcept> // std::length_error, std::invalid_argument
+#include <system_error>
+#include <limits>
+#include <utility> // std::move
+
+#include <sys/mman.h> // mmap, munmap, shm_open, shm_unlink, memfd_create
+#include <sys/stat.h> // fstat
+#include <fcntl.h> // fcntl, open, O_RDWR
+#include <unistd.h> // close, ftruncate, dup, getpid
+#include <cerrno>
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+/**
+ * @brief Refers to bytes in a @c shared_memory_arena, to be sent to another process.
+ *
+ * This is a trivially copyable type, which can be written to a socket or pipe as is
+ * (between processes on the same host).
+ */
+struct shared_memory_handle {
+  std::uint64_t offset; // from the start of the slot storage
+  std::uint64_t length;
+  std::uint32_t generation;
+};
+
+namespace detail {
+
+inline constexpr std::uint64_t shm_magic { 0x43484f5053484d31u }; // "CHOPSHM1"
+inline constexpr std::uint32_t shm_max_processes { 32u };
+inline constexpr std::size_t shm_align { 64u };
+
+#if defined(F_OFD_SETLK)
+inline constexpr int shm_setlk { F_OFD_SETLK };
+#else
+inline constexpr int shm_setlk { F_SETLK };
+#endif
+
+// beginning of the shared memory object; the slot states follow, then the slots
+struct shm_header {
+  std::atomic<std::uint64_t> magic; // stored last, when the header is initialized
+  std::uint32_t num_slots;
+  std::uint32_t reserved;
+  std::uint64_t slot_size;
+  std::uint64_t data_offset;
+  std::atomic<std::uint32_t> alloc_hint;
+  std::atomic<std::int32_t> pids[shm_max_processes]; // informational only
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "lock free (address free) atomics are needed in shared memory");
+
+// slot state: generation in the high 32 bits, one bit per holding process in the low
+inline constexpr std::uint64_t shm_holders_mask { 0xFFFFFFFFu };
+
+constexpr std::size_t shm_round_up(std::size_t n, std::size_t align) noexcept {
+  return (n + align - 1u) / align * align;
+}
+
+[[noreturn]] inline void throw_shm_error(const char* what) {
+  throw std::system_error(errno, std::system_category(), what);
+}
+
+// write lock (or unlock) one byte of the shared memory object, without waiting
+inline bool shm_lock(int fd, std::uint32_t idx, short type) noexcept {
+  struct ::flock fl { };
+  fl.l_type = type;
+  fl.l_whence = SEEK_SET;
+  fl.l_start = static_cast<off_t>(idx);
+  fl.l_len = 1;
+  return ::fcntl(fd, shm_setlk, &fl) == 0;
+}
+
+// the mapping, and the state of this process for it; shared by the arena object and
+// every buffer referring into it, so the mapping outlives all of them
+class shm_region {
+public:
+  int m_fd { -1 };
+  std::byte* m_base { nullptr };
+  std::size_t m_map_size { 0u };
+  shm_header* m_hdr { nullptr };
+  std::atomic<std::uint64_t>* m_states { nullptr };
+  std::byte* m_data { nullptr };
+  std::uint32_t m_entry { shm_max_processes };
+  std::mutex m_mutex;
+  std::vector<std::uint32_t> m_local; // references held by this process, per slot
+
+  shm_region() = default;
+  shm_region(const shm_region&) = delete;
+  shm_region& operator=(const shm_region&) = delete;
+
+  ~shm_region() {
+    if (m_entry < shm_max_processes) {
+      m_hdr->pids[m_entry].store(0, std::memory_order_relaxed);
+      shm_lock(m_fd, m_entry, F_UNLCK);
+    }
+    if (m_base != nullptr) {
+      ::munmap(m_base, m_map_size);
+    }
+    if (m_fd >= 0) {
+      ::close(m_fd);
+    }
+  }
+
+  std::uint64_t bit() const noexcept { return std::uint64_t(1u) << m_entry; }
+  std::size_t slot_size() const noexcept { return static_cast<std::size_t>(m_hdr->slot_size); }
+  std::uint32_t num_slots() const noexcept { return m_hdr->num_slots; }
+
+  // take a reference to a slot of the given generation for this process
+  bool acquire(std::uint32_t slot, std::uint32_t gen) noexcept {
+    auto& st { m_states[slot] };
+    auto s { st.load(std::memory_order_acquire) };
+    while (static_cast<std::uint32_t>(s >> 32) == gen && (s & shm_holders_mask) != 0u) {
+      if (st.compare_exchange_weak(s, s | bit(), std::memory_order_acq_rel)) {
+        return true;
+      }
+    }
+    return false; // reused, or free
+  }
+
+  static void release_bit(std::atomic<std::uint64_t>& st, std::uint64_t b) noexcept {
+    st.fetch_and(~b, std::memory_order_acq_rel);
+  }
+
+  // release the references of a process entry that is no longer attached
+  bool clear_entry(std::uint32_t entry) noexcept {
+    std::uint64_t b { std::uint64_t(1u) << entry };
+    bool found { false };
+    for (std::uint32_t i = 0u; i < num_slots(); ++i) {
+      if (m_states[i].load(std::memory_order_relaxed) & b) {
+        release_bit(m_states[i], b);
+        found = true;
+      }
+    }
+    m_hdr->pids[entry].store(0, std::memory_order_relaxed);
+    return found;
+  }
+
+  void attach() {
+    for (std::uint32_t i = 0u; i < shm_max_processes; ++i) {
+      if (shm_lock(m_fd, i, F_WRLCK)) {
+        clear_entry(i); // left over from a process that crashed
+        m_hdr->pids[i].store(static_cast<std::int32_t>(::getpid()), std::memory_order_relaxed);
+        m_entry = i;
+        m_local.assign(num_slots(), 0u);
+        return;
+      }
+    }
+    throw std::system_error(std::make_error_code(std::errc::device_or_resource_busy),
+                            "shared_memory_arena: too many attached processes");
+  }
+
+  void map(int fd) {
+    m_fd = fd;
+    struct ::stat st;
+    if (::fstat(m_fd, &st) != 0) {
+      throw_shm_error("shared_memory_arena: fstat");
+    }
+    if (static_cast<std::size_t>(st.st_size) < sizeof(shm_header)) {
+      throw std::system_error(std::make_error_code(std::errc::invalid_argument),
+                              "shared_memory_arena: not an arena");
+    }
+    m_map_size = static_cast<std::size_t>(st.st_size);
+    auto addr = ::mmap(nullptr, m_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (addr == MAP_FAILED) {
+      throw_shm_error("shared_memory_arena: mmap");
+    }
+    m_base = static_cast<std::byte*>(addr);
+    m_hdr = reinterpret_cast<shm_header*>(m_base);
+    m_states = reinterpret_cast<std::atomic<std::uint64_t>*>(m_base + shm_round_up(sizeof(shm_header), 8u));
+  }
+
+  void init(std::uint32_t num, std::size_t slot_sz, std::size_t data_off) {
+    ::new (static_cast<void*>(m_hdr)) shm_header { { 0u }, num, 0u, slot_sz, data_off, { 0u }, { } };
+    for (std::uint32_t i = 0u; i < num; ++i) {
+      ::new (static_cast<void*>(m_states + i)) std::atomic<std::uint64_t>(0u);
+    }
+    m_data = m_base + data_off;
+    m_hdr->magic.store(shm_magic, std::memory_order_release);
+  }
+
+  void validate() {
+    if (m_hdr->magic.load(std::memory_order_acquire) != shm_magic ||
+        m_hdr->data_offset + std::uint64_t(m_hdr->num_slots) * m_hdr->slot_size > m_map_size) {
+      throw std::system_error(std::make_error_code(std::errc::invalid_argument),
+                              "shared_memory_arena: not an arena, or not initialized");
+    }
+    m_data = m_base + m_hdr->data_offset;
+  }
+};
+
+inline constexpr std::uint32_t shm_no_slot { std::numeric_limits<std::uint32_t>::max() };
+
+// deleter of the shared_ptr for a slot, releases the process reference with the last
+// local reference; the slot is assigned after the shared_ptr is created
+struct shm_slot_deleter {
+  std::shared_ptr<shm_region> m_region;
+  std::uint32_t m_slot { shm_no_slot };
+
+  void operator()(const std::byte*) const noexcept {
+    if (m_slot == shm_no_slot) {
+      return;
+    }
+    std::lock_guard<std::mutex> lk(m_region->m_mutex);
+    if (--m_region->m_local[m_slot] == 0u) {
+      shm_region::release_bit(m_region->m_states[m_slot], m_region->bit());
+    }
+  }
+};
+
+} // end detail namespace
+
+/**
+ * @brief A slot of a @c shared_memory_arena being written, before it is published
+ * as a @c const_shared_buffer.
+ */
+class shared_memory_slot {
+private:
+  std::shared_ptr<std::byte> m_data;
+  std::size_t m_capacity;
+
+  friend class shared_memory_arena;
+
+  shared_memory_slot(std::shared_ptr<std::byte> data, std::size_t cap) noexcept :
+      m_data(std::move(data)), m_capacity(cap) { }
+
+public:
+  shared_memory_slot(shared_memory_slot&&) noexcept = default;
+  shared_memory_slot& operator=(shared_memory_slot&&) noexcept = default;
+  shared_memory_slot(const shared_memory_slot&) = delete;
+  shared_memory_slot& operator=(const shared_memory_slot&) = delete;
+
+  std::byte* data() const noexcept { return m_data.get(); }
+  std::size_t capacity() const noexcept { return m_capacity; }
+  std::span<std::byte> span() const noexcept { return { m_data.get(), m_capacity }; }
+
+/**
+ * @brief Publish the first bytes of the slot as a @c const_shared_buffer, moving the
+ * reference into it.
+ *
+ * @pre @c len is not greater than @c capacity, and the bytes are not modified after
+ * they are published.
+ */
+  const_shared_buffer publish(std::size_t len) && noexcept {
+    return const_shared_buffer(std::shared_ptr<const std::byte>(std::move(m_data)), len);
+  }
+};
+
+/**
+ * @brief A shared memory arena where buffers can be passed between processes as a
+ * @c shared_memory_handle, see the file documentation.
+ *
+ * The arena object can be moved, and buffers refer to the mapping independently, so
+ * they stay valid when the arena object is destroyed.
+ */
+class shared_memory_arena {
+public:
+  static constexpr std::uint32_t max_processes { detail::shm_max_processes };
+
+private:
+  std::shared_ptr<detail::shm_region> m_region;
+
+  explicit shared_memory_arena(std::shared_ptr<detail::shm_region> reg) noexcept :
+      m_region(std::move(reg)) { }
+
+  static shared_memory_arena create_from_fd(int fd, std::size_t num_slots, std::size_t slot_size) {
+    auto reg { std::make_shared<detail::shm_region>() };
+    reg->m_fd = fd; // closed by the region, including on an exception
+    if (num_slots == 0u || num_slots > std::numeric_limits<std::uint32_t>::max() || slot_size == 0u) {
+      throw std::invalid_argument("shared_memory_arena: invalid number of slots or slot size");
+    }
+    auto slot_sz { detail::shm_round_up(slot_size, detail::shm_align) };
+    auto data_off { detail::shm_round_up(detail::shm_round_up(sizeof(detail::shm_header), 8u) +
+                                         num_slots * sizeof(std::uint64_t), detail::shm_align) };
+    if (::ftruncate(fd, static_cast<off_t>(data_off + num_slots * slot_sz)) != 0) {
+      detail::throw_shm_error("shared_memory_arena: ftruncate");
+    }
+    reg->map(fd);
+    reg->init(static_cast<std::uint32_t>(num_slots), slot_sz, data_off);
+    reg->attach();
+    return shared_memory_arena(std::move(reg));
+  }
+
+  static shared_memory_arena open_fd(int fd) {
+    auto reg { std::make_shared<detail::shm_region>() };
+    reg->m_fd = fd;
+    reg->map(fd);
+    reg->validate();
+    reg->attach();
+    return shared_memory_arena(std::move(reg));
+  }
+
+  // the shared_ptr (with its control block) is created before a slot is taken, so a
+  // failed allocation leaves nothing held
+  std::shared_ptr<std::byte> unbound_slot_ptr() const {
+    return std::shared_ptr<std::byte>(m_region->m_data, detail::shm_slot_deleter { m_region });
+  }
+
+  std::shared_ptr<std::byte> bind_slot_ptr(std::shared_ptr<std::byte>&& sp, std::uint32_t slot, 
+                                           std::size_t off) const noexcept {
+    std::get_deleter<detail::shm_slot_deleter>(sp)->m_slot = slot;
+    auto ptr { m_region->m_data + std::size_t(slot) * slot_size() + off };
+    return std::shared_ptr<std::byte>(std::move(sp), ptr);
+  }
+
+public:
+
+/**
+ * @brief Create a named shared memory object and initialize the arena in it.
+ *
+ * @param name Name for @c shm_open, such as @c "/feed".
+ *
+ * @param num_slots Number of slots.
+ *
+ * @param slot_size Size of each slot (the largest buffer); rounded up to a multiple
+ * of 64 bytes.
+ *
+ * @throw std::system_error If the name already exists, or the object cannot be
+ * created or mapped.
+ */
+  static shared_memory_arena create(const std::string& name, std::size_t num_slots, std::size_t slot_size) {
+    int fd { ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600) };
+    if (fd < 0) {
+      detail::throw_shm_error("shared_memory_arena: shm_open");
+    }
+    try {
+      return create_from_fd(fd, num_slots, slot_size);
+    }
+    catch (...) {
+      ::shm_unlink(name.c_str());
+      throw;
+    }
+  }
+
+/**
+ * @brief Attach to an arena created by another process.
+ *
+ * @throw std::system_error If the object does not exist, is not an arena, or
+ * @c max_processes are already attached.
+ */
+  static shared_memory_arena open(const std::string& name) {
+    int fd { ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0) };
+    if (fd < 0) {
+      detail::throw_shm_error("shared_memory_arena: shm_open");
+    }
+    return open_fd(fd);
+  }
+
+#if defined(__linux__)
+/**
+ * @brief Create an arena in an anonymous memory file (@c memfd_create), whose file
+ * descriptor can be passed to other processes (e.g. with @c SCM_RIGHTS), which then
+ * call @c from_fd.
+ */
+  static shared_memory_arena create_anonymous(std::size_t num_slots, std::size_t slot_size) {
+    int fd { ::memfd_create("shared_memory_arena", MFD_CLOEXEC) };
+    if (fd < 0) {
+      detail::throw_shm_error("shared_memory_arena: memfd_create");
+    }
+    return create_from_fd(fd, num_slots, slot_size);
+  }
+#endif
+
+/**
+ * @brief Attach to an arena through a file descriptor (the caller keeps ownership of
+ * @c fd).
+ *
+ * On Linux the file is opened again through @c /proc/self/fd, since the locks that
+ * tell attached processes apart belong to an open file description, which a
+ * duplicated (or passed with @c SCM_RIGHTS) descriptor shares. Elsewhere the
+ * descriptor is duplicated, see the note in the file documentation.
+ */
+  static shared_memory_arena from_fd(int fd) {
+#if defined(__linux__)
+    std::string path { "/proc/self/fd/" + std::to_string(fd) };
+    int dfd { ::open(path.c_str(), O_RDWR | O_CLOEXEC) };
+#else
+    int dfd { ::fcntl(fd, F_DUPFD_CLOEXEC, 0) };
+#endif
+    if (dfd < 0) {
+      detail::throw_shm_error("shared_memory_arena: open");
+    }
+    return open_fd(dfd);
+  }
+
+/**
+ * @brief Remove the name of a shared memory object; attached processes are not
+ * affected.
+ */
+  static void remove(const std::string& name) noexcept {
+    ::shm_unlink(name.c_str());
+  }
+
+  int fd() const noexcept { return m_region->m_fd; }
+  std::size_t slot_size() const noexcept { return m_region->slot_size(); }
+  std::size_t num_slots() const noexcept { return m_region->num_slots(); }
+
+/**
+ * @brief Allocate a free slot to be written, if there is one.
+ */
+  std::optional<shared_memory_slot> try_allocate() {
+    auto& reg { *m_region };
+    auto sp { unbound_slot_ptr() };
+    auto num { reg.num_slots() };
+    auto start { reg.m_hdr->alloc_hint.load(std::memory_order_relaxed) };
+    for (std::uint32_t n = 0u; n < num; ++n) {
+      auto slot { (start + n) % num };
+      auto& st { reg.m_states[slot] };
+      auto s { st.load(std::memory_order_relaxed) };
+      if ((s & detail::shm_holders_mask) != 0u) {
+        continue;
+      }
+      // a new generation makes handles to the previous contents stale
+      auto next { ((s >> 32) + 1u) << 32 | reg.bit() };
+      if (st.compare_exchange_strong(s, next, std::memory_order_acq_rel)) {
+        reg.m_hdr->alloc_hint.store(slot + 1u, std::memory_order_relaxed);
+        {
+          std::lock_guard<std::mutex> lk(reg.m_mutex);
+          reg.m_local[slot] = 1u;
+        }
+        return shared_memory_slot(bind_slot_ptr(std::move(sp), slot, 0u), slot_size());
+      }
+    }
+    return std::nullopt;
+  }
+
+/**
+ * @brief Allocate a free slot to be written.
+ *
+ * @throw std::bad_alloc If all slots are in use.
+ */
+  shared_memory_slot allocate() {
+    auto slot { try_allocate() };
+    if (!slot) {
+      throw std::bad_alloc();
+    }
+    return std::move(*slot);
+  }
+
+/**
+ * @brief Copy bytes into a newly allocated slot, and publish it.
+ *
+ * @throw std::length_error If the bytes do not fit in a slot.
+ *
+ * @throw std::bad_alloc If all slots are in use.
+ */
+  const_shared_buffer copy(std::span<const std::byte> sp) {
+    if (sp.size() > slot_size()) {
+      throw std::length_error("shared_memory_arena: bytes larger than a slot");
+    }
+    auto slot { allocate() };
+    if (!sp.empty()) {
+      std::memcpy(slot.data(), sp.data(), sp.size());
+    }
+    return std::move(slot).publish(sp.size());
+  }
+
+/**
+ * @brief Return the handle for a buffer referring into this arena (including a
+ * slice of one), to be sent to another process.
+ *
+ * @pre The buffer is alive (so the handle refers to its current contents) until
+ * the receiving processes have called @c view.
+ *
+ * @throw std::invalid_argument If the buffer does not refer into this arena.
+ */
+  shared_memory_handle handle(const const_shared_buffer& buf) const {
+    const auto& reg { *m_region };
+    auto total { std::size_t(reg.num_slots()) * slot_size() };
+    if (buf.data() < reg.m_data || buf.data() >= reg.m_data + total) {
+      throw std::invalid_argument("shared_memory_arena: buffer not in this arena");
+    }
+    auto off { static_cast<std::size_t>(buf.data() - reg.m_data) };
+    auto slot { static_cast<std::uint32_t>(off / slot_size()) };
+    auto gen { static_cast<std::uint32_t>(reg.m_states[slot].load(std::memory_order_acquire) >> 32) };
+    return { off, buf.size(), gen };
+  }
+
+/**
+ * @brief Return a @c const_shared_buffer referring to the bytes of a handle, without
+ * copying.
+ *
+ * @return The buffer, or an empty @c std::optional if the handle is stale (every
+ * process released the slot, and it might have been reused) or invalid.
+ */
+  std::optional<const_shared_buffer> view(const shared_memory_handle& hdl) const {
+    auto& reg { *m_region };
+    auto slot_sz { slot_size() };
+    auto slot { hdl.offset / slot_sz };
+    auto off { hdl.offset % slot_sz };
+    if (slot >= reg.num_slots() || hdl.length > slot_sz - off) {
+      return std::nullopt;
+    }
+    auto idx { static_cast<std::uint32_t>(slot) };
+    auto sp { unbound_slot_ptr() };
+    {
+      std::lock_guard<std::mutex> lk(reg.m_mutex);
+      if (reg.m_local[idx] != 0u) { // already held by this process
+        auto s { reg.m_states[idx].load(std::memory_order_acquire) };
+        if (static_cast<std::uint32_t>(s >> 32) != hdl.generation) {
+          return std::nullopt;
+        }
+      }
+      else if (!reg.acquire(idx, hdl.generation)) {
+        return std::nullopt;
+      }
+      ++reg.m_local[idx];
+    }
+    return const_shared_buffer(bind_slot_ptr(std::move(sp), idx, static_cast<std::size_t>(off)),
+                               static_cast<std::size_t>(hdl.length));
+  }
+
+/**
+ * @brief Release the references held by processes that are no longer attached, e.g.
+ * after a crash.
+ *
+ * @return Number of such processes that were holding references.
+ */
+  std::size_t reclaim() {
+    auto& reg { *m_region };
+    std::size_t cnt { 0u };
+    for (std::uint32_t i = 0u; i < max_processes; ++i) {
+      if (i != reg.m_entry && detail::shm_lock(reg.m_fd, i, F_WRLCK)) {
+        cnt += reg.clear_entry(i) ? 1u : 0u;
+        detail::shm_lock(reg.m_fd, i, F_UNLCK);
+      }
+    }
+    return cnt;
+  }
+
+/**
+ * @brief Return the number of slots not held by any process.
+ */
+  std::size_t free_slots() const noexcept {
+    const auto& reg { *m_region };
+    std::size_t cnt { 0u };
+    for (std::uint32_t i = 0u; i < reg.num_slots(); ++i) {
+      cnt += (reg.m_states[i].load(std::memory_order_relaxed) & detail::shm_holders_mask) == 0u ? 1u : 0u;
+    }
+    return cnt;
+  }
+};
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,503 @@
+/** @file
+ *
+ * @brief Lock-free ring buffers passing @c const_shared_buffer messages between threads
+ * without allocating memory per message.
+ *
+ * Producers write messages directly into one large reference counted region, and
+ * consumers receive each message as a @c const_shared_buffer referring to the bytes in
+ * the region. The space of a message is reused only after the consumer (and every copy
+ * of the @c const_shared_buffer it received) is done with it, so the immutability of a
+ * @c const_shared_buffer is never violated.
+ *
+ * No memory is allocated per message: the reference count block of each
+ * @c const_shared_buffer is constructed inside a header in the region, in front of the
+ * message bytes. Releasing the last reference marks the header as released, which is
+ * how the space is returned to the producers. The region stays alive until the ring
+ * buffer and all messages are destroyed.
+ *
+ * There are two variants:
+ * - @c shared_ring_buffer, a single producer single consumer ring with variable size
+ *   messages. The producer reserves a contiguous region of any size, writes into it, and
+ *   commits it. There are no locks or compare-and-swap loops.
+ * - @c mpmc_shared_ring_buffer, a multiple producer multiple consumer ring with fixed
+ *   size slots, using a bounded queue with per-slot sequence numbers. It is lock-free.
+ *
+ * @note Space is reused in order, so a message held for a long time by a consumer
+ * stops the producers from reusing any space after it (and the ring eventually stays
+ * full) until the message is released.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SHARED_RING_BUFFER_HPP_INCLUDED
+#define SHARED_RING_BUFFER_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t, std::max_align_t
+#include <cstdint> // std::uint64_t, std::int64_t
+#include <atomic>
+#include <memory> // std::shared_ptr, std::allocator
+#include <new> // operator new, std::align_val_t, placement new, std::launder
+#include <optional>
+#include <span>
+#include <utility> // std::move
+#include <algorithm> // std::copy
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+namespace detail {
+
+// room for the reference count block of a message, which is constructed in the header
+inline constexpr std::size_t ring_cb_space = 64u;
+
+inline constexpr std::size_t ring_cache_line = 64u;
+
+// header in front of the bytes of each message; the state is a record state for
+// shared_ring_buffer and a sequence number for mpmc_shared_ring_buffer
+struct ring_record {
+  alignas(std::max_align_t) std::byte cb[ring_cb_space];
+  std::atomic<std::uint64_t> state;
+  std::uint64_t size;
+};
+
+inline constexpr std::size_t ring_hdr_size = sizeof(ring_record);
+inline constexpr std::size_t ring_align = alignof(ring_record);
+
+constexpr std::size_t ring_round_up(std::size_t sz, std::size_t align) noexcept {
+  return (sz + align - 1u) / align * align;
+}
+
+inline std::shared_ptr<std::byte[]> make_ring_region(std::size_t sz) {
+  auto p { static_cast<std::byte*>(::operator new(sz, std::align_val_t{ring_cache_line})) };
+  return std::shared_ptr<std::byte[]>(p, [sz] (std::byte* q) {
+      ::operator delete(q, sz, std::align_val_t{ring_cache_line});
+    } );
+}
+
+inline ring_record* ring_record_at(std::byte* p) noexcept {
+  return std::launder(reinterpret_cast<ring_record*>(p));
+}
+
+struct ring_noop_deleter {
+  void operator()(const std::byte*) const noexcept { }
+};
+
+// places the reference count block of a message in the record header, and releases
+// the record (by storing a state value) when the block is deallocated; deallocation
+// uses a copy of the allocator, which keeps the region alive until it is done
+template <typename T>
+class ring_allocator {
+public:
+  using value_type = T;
+
+  std::shared_ptr<std::byte[]> m_region;
+  ring_record* m_rec;
+  std::uint64_t m_release;
+
+  ring_allocator(std::shared_ptr<std::byte[]> region, ring_record* rec, std::uint64_t release) noexcept :
+      m_region(std::move(region)), m_rec(rec), m_release(release) { }
+
+  template <typename U>
+  ring_allocator(const ring_allocator<U>& rhs) noexcept :
+      m_region(rhs.m_region), m_rec(rhs.m_rec), m_release(rhs.m_release) { }
+
+  T* allocate(std::size_t n) {
+    if constexpr (sizeof(T) <= ring_cb_space && alignof(T) <= ring_align) {
+      if (n == 1u) {
+        return reinterpret_cast<T*>(m_rec->cb);
+      }
+    }
+    return std::allocator<T>().allocate(n); // a larger reference count block than expected
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    if (static_cast<void*>(p) != static_cast<void*>(m_rec->cb)) {
+      std::allocator<T>().deallocate(p, n);
+    }
+    m_rec->state.store(m_release, std::memory_order_release);
+  }
+
+  template <typename U>
+  bool operator==(const ring_allocator<U>& rhs) const noexcept { return m_rec == rhs.m_rec; }
+};
+
+// a const_shared_buffer for the bytes following a record header
+inline const_shared_buffer make_ring_message(const std::shared_ptr<std::byte[]>& region,
+                                             ring_record* rec, std::uint64_t release) {
+  auto ptr { reinterpret_cast<const std::byte*>(rec) + ring_hdr_size };
+  try {
+    return const_shared_buffer(std::shared_ptr<const std::byte>(ptr, ring_noop_deleter(),
+                                   ring_allocator<std::byte>(region, rec, release)),
+                               static_cast<std::size_t>(rec->size));
+  }
+  catch (...) {
+    rec->state.store(release, std::memory_order_release); // space is not lost
+    throw;
+  }
+}
+
+} // end detail namespace
+
+/**
+ * @brief Single producer single consumer ring buffer of variable size messages.
+ *
+ * One thread calls @c reserve and @c commit, and one (other) thread calls @c try_pop.
+ * Each message takes a header (@c header_size bytes) plus its size rounded up to a
+ * multiple of 16 bytes, and is contiguous in the region.
+ */
+class shared_ring_buffer {
+public:
+  using size_type = std::size_t;
+
+  static constexpr size_type header_size = detail::ring_hdr_size;
+
+private:
+  static constexpr std::uint64_t live = 0u;
+  static constexpr std::uint64_t released = 1u;
+  static constexpr std::uint64_t padding = 2u;
+
+  std::shared_ptr<std::byte[]> m_region;
+  size_type m_capacity;
+
+  // producer state
+  alignas(detail::ring_cache_line) std::uint64_t m_write { 0u }; // start of next record
+  std::uint64_t m_reclaim { 0u }; // oldest record not yet released
+
+  // published by the producer, read by the consumer
+  alignas(detail::ring_cache_line) std::atomic<std::uint64_t> m_published { 0u };
+
+  // consumer state
+  alignas(detail::ring_cache_line) std::uint64_t m_read { 0u };
+
+private:
+
+  static constexpr size_type record_size(size_type sz) noexcept {
+    return detail::ring_hdr_size + detail::ring_round_up(sz, detail::ring_align);
+  }
+
+  size_type offset(std::uint64_t pos) const noexcept { return static_cast<size_type>(pos % m_capacity); }
+
+  // bytes at the end of the region too small for a header are skipped implicitly
+  size_type implicit_skip(std::uint64_t pos) const noexcept {
+    auto tail { m_capacity - offset(pos) };
+    return tail < detail::ring_hdr_size ? tail : 0u;
+  }
+
+  detail::ring_record* record(std::uint64_t pos) const noexcept {
+    return detail::ring_record_at(m_region.get() + offset(pos));
+  }
+
+  void reclaim() noexcept {
+    while (m_reclaim < m_write) {
+      if (auto skip = implicit_skip(m_reclaim); skip != 0u) {
+        m_reclaim += skip;
+        continue;
+      }
+      auto rec { record(m_reclaim) };
+      if (rec->state.load(std::memory_order_acquire) != released) {
+        break;
+      }
+      m_reclaim += record_size(static_cast<size_type>(rec->size));
+    }
+  }
+
+public:
+
+/**
+ * @brief Construct a @c shared_ring_buffer, allocating the region.
+ *
+ * @param capacity Size of the region in bytes, rounded up to a multiple of 16; this
+ * includes the message headers.
+ *
+ * @throw std::bad_alloc If the region cannot be allocated.
+ */
+  explicit shared_ring_buffer(size_type capacity) :
+      m_region(detail::make_ring_region(detail::ring_round_up(capacity, detail::ring_align))),
+      m_capacity(detail::ring_round_up(capacity, detail::ring_align)) { }
+
+  shared_ring_buffer(const shared_ring_buffer&) = delete;
+  shared_ring_buffer& operator=(const shared_ring_buffer&) = delete;
+
+/**
+ * @brief Reserve contiguous space for a message, to be written and then committed.
+ *
+ * Space of messages that have been released is reclaimed first. Called by the
+ * producer only.
+ *
+ * @param sz Maximum size of the message.
+ *
+ * @return @c std::span of @c sz bytes to write the message into; an empty @c std::span
+ * (with a null pointer) if there is not enough free space.
+ */
+  std::span<std::byte> reserve(size_type sz) noexcept {
+    auto need { record_size(sz) };
+    if (need > m_capacity) {
+      return { };
+    }
+    reclaim();
+    auto pos { m_write + implicit_skip(m_write) };
+    auto tail { m_capacity - offset(pos) };
+    auto start { need > tail ? pos + tail : pos }; // after a padding record if it does not fit
+    if (start + need - m_reclaim > m_capacity) {
+      return { };
+    }
+    if (start != pos) {
+      auto pad = ::new (static_cast<void*>(m_region.get() + offset(pos))) detail::ring_record;
+      pad->size = tail - detail::ring_hdr_size;
+      pad->state.store(padding, std::memory_order_relaxed); // published with the next commit
+    }
+    m_write = start;
+    return { m_region.get() + offset(start) + detail::ring_hdr_size, sz };
+  }
+
+/**
+ * @brief Publish the message written into the space returned by @c reserve, making it
+ * available to the consumer.
+ *
+ * Called by the producer only.
+ *
+ * @pre @c reserve returned a non-empty span at least @c sz bytes long, and nothing has
+ * been committed since.
+ *
+ * @param sz Size of the message.
+ */
+  void commit(size_type sz) noexcept {
+    auto rec = ::new (static_cast<void*>(m_region.get() + offset(m_write))) detail::ring_record;
+    rec->size = sz;
+    rec->state.store(live, std::memory_order_relaxed);
+    m_write += record_size(sz);
+    m_published.store(m_write, std::memory_order_release);
+  }
+
+/**
+ * @brief Copy a message into the ring, as a @c reserve followed by a @c commit.
+ *
+ * Called by the producer only.
+ *
+ * @param sp Bytes of the message.
+ *
+ * @return @c true if there was enough free space.
+ */
+  bool try_push(std::span<const std::byte> sp) noexcept {
+    auto dst { reserve(sp.size()) };
+    if (dst.data() == nullptr) {
+      return false;
+    }
+    std::copy(sp.begin(), sp.end(), dst.begin());
+    commit(sp.size());
+    return true;
+  }
+
+/**
+ * @brief Return the next message, if any.
+ *
+ * The bytes stay in the region; the space is reused after the returned
+ * @c const_shared_buffer (and all copies and slices of it) are destroyed. Called by the
+ * consumer only.
+ *
+ * @return @c const_shared_buffer referring to the message; an empty @c std::optional
+ * if no message is available.
+ */
+  std::optional<const_shared_buffer> try_pop() {
+    auto avail { m_published.load(std::memory_order_acquire) };
+    while (m_read < avail) {
+      if (auto skip = implicit_skip(m_read); skip != 0u) {
+        m_read += skip;
+        continue;
+      }
+      auto rec { record(m_read) };
+      auto rsz { record_size(static_cast<size_type>(rec->size)) };
+      if (rec->state.load(std::memory_order_relaxed) == padding) {
+        rec->state.store(released, std::memory_order_release);
+        m_read += rsz;
+        continue;
+      }
+      auto msg { detail::make_ring_message(m_region, rec, released) };
+      m_read += rsz;
+      return msg;
+    }
+    return { };
+  }
+
+/**
+ * @brief Return the size of the region, including message headers.
+ */
+  size_type capacity() const noexcept { return m_capacity; }
+
+};
+
+/**
+ * @brief Multiple producer multiple consumer ring buffer with fixed size slots.
+ *
+ * Any number of threads can call @c try_reserve and @c commit, and any number of threads
+ * can call @c try_pop. Each slot holds one message of up to @c slot_size bytes, and slots
+ * are separated by at least a cache line.
+ *
+ * @note A slot that has been reserved must be committed, since consumers take messages
+ * in order.
+ */
+class mpmc_shared_ring_buffer {
+public:
+  using size_type = std::size_t;
+
+/**
+ * @brief A reserved slot, to be written into and then passed to @c commit.
+ */
+  struct reservation {
+    std::span<std::byte> bytes;
+    std::uint64_t pos;
+  };
+
+private:
+  std::shared_ptr<std::byte[]> m_region;
+  size_type m_slot_size;
+  size_type m_slot_count;
+  size_type m_stride;
+
+  alignas(detail::ring_cache_line) std::atomic<std::uint64_t> m_enqueue { 0u };
+  alignas(detail::ring_cache_line) std::atomic<std::uint64_t> m_dequeue { 0u };
+
+private:
+
+  detail::ring_record* slot(std::uint64_t pos) const noexcept {
+    return detail::ring_record_at(m_region.get() + (pos % m_slot_count) * m_stride);
+  }
+
+  static std::int64_t diff(std::uint64_t a, std::uint64_t b) noexcept {
+    return static_cast<std::int64_t>(a - b);
+  }
+
+public:
+
+/**
+ * @brief Construct a @c mpmc_shared_ring_buffer, allocating the region.
+ *
+ * @param slot_size Maximum message size.
+ *
+ * @param slot_count Number of slots, the maximum number of messages in the ring
+ * (including messages popped but not yet released).
+ *
+ * @throw std::bad_alloc If the region cannot be allocated.
+ */
+  mpmc_shared_ring_buffer(size_type slot_size, size_type slot_count) :
+      m_region(), m_slot_size(slot_size), m_slot_count(slot_count),
+      m_stride(detail::ring_round_up(detail::ring_hdr_size + slot_size, detail::ring_cache_line)) {
+    m_region = detail::make_ring_region(m_stride * m_slot_count);
+    for (size_type i = 0u; i < m_slot_count; ++i) {
+      auto rec = ::new (static_cast<void*>(m_region.get() + i * m_stride)) detail::ring_record;
+      rec->size = 0u;
+      rec->state.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  mpmc_shared_ring_buffer(const mpmc_shared_ring_buffer&) = delete;
+  mpmc_shared_ring_buffer& operator=(const mpmc_shared_ring_buffer&) = delete;
+
+/**
+ * @brief Reserve a slot for a message.
+ *
+ * @return @c reservation with a @c std::span of @c slot_size bytes to write the message
+ * into; an empty @c std::optional if all slots are in use.
+ */
+  std::optional<reservation> try_reserve() noexcept {
+    auto pos { m_enqueue.load(std::memory_order_relaxed) };
+    for (;;) {
+      auto rec { slot(pos) };
+      auto d { diff(rec->state.load(std::memory_order_acquire), pos) };
+      if (d == 0) {
+        if (m_enqueue.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) {
+          return reservation { { reinterpret_cast<std::byte*>(rec) + detail::ring_hdr_size, m_slot_size }, pos };
+        }
+      }
+      else if (d < 0) {
+        return { };
+      }
+      else {
+        pos = m_enqueue.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+/**
+ * @brief Publish the message written into a reserved slot.
+ *
+ * @pre @c sz is not greater than @c slot_size.
+ *
+ * @param res Reservation returned by @c try_reserve.
+ *
+ * @param sz Size of the message.
+ */
+  void commit(const reservation& res, size_type sz) noexcept {
+    auto rec { slot(res.pos) };
+    rec->size = sz;
+    rec->state.store(res.pos + 1u, std::memory_order_release);
+  }
+
+/**
+ * @brief Copy a message into the ring, as a @c try_reserve followed by a @c commit.
+ *
+ * @pre The size of the message is not greater than @c slot_size.
+ *
+ * @return @c true if a slot was available.
+ */
+  bool try_push(std::span<const std::byte> sp) noexcept {
+    auto res { try_reserve() };
+    if (!res) {
+      return false;
+    }
+    std::copy(sp.begin(), sp.end(), res->bytes.begin());
+    commit(*res, sp.size());
+    return true;
+  }
+
+/**
+ * @brief Return the next message, if any.
+ *
+ * The slot is reused after the returned @c const_shared_buffer (and all copies and
+ * slices of it) are destroyed.
+ *
+ * @return @c const_shared_buffer referring to the message; an empty @c std::optional
+ * if no message is available.
+ */
+  std::optional<const_shared_buffer> try_pop() {
+    auto pos { m_dequeue.load(std::memory_order_relaxed) };
+    for (;;) {
+      auto rec { slot(pos) };
+      auto d { diff(rec->state.load(std::memory_order_acquire), pos + 1u) };
+      if (d == 0) {
+        if (m_dequeue.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) {
+          return detail::make_ring_message(m_region, rec, pos + m_slot_count);
+        }
+      }
+      else if (d < 0) {
+        return { };
+      }
+      else {
+        pos = m_dequeue.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+/**
+ * @brief Return the maximum message size.
+ */
+  size_type slot_size() const noexcept { return m_slot_size; }
+
+/**
+ * @brief Return the number of slots.
+ */
+  size_type slot_count() const noexcept { return m_slot_count; }
+
+};
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,126 @@
+/** @file
+ *
+ * @brief Compile time byte buffers in static storage, shared as @c const_shared_buffer
+ * objects without any allocation or reference counting.
+ *
+ * Protocol headers, canned replies, and other messages known at compile time can be
+ * defined as @c static_shared_buffer objects, which are literal types holding their
+ * bytes in a @c std::array:
+ *
+ * @code
+ *   constexpr chops::static_shared_buffer pong { "PONG\r\n" }; // six bytes, no null
+ *   // ...
+ *   send(pong.share()); // a const_shared_buffer, no allocation
+ * @endcode
+ *
+ * The @c const_shared_buffer returned by @c share (or by @c make_static_shared_buffer
+ * for any bytes in static storage) refers to the bytes through an aliasing
+ * @c std::shared_ptr with no owner. Copying and destroying it (and its slices) does not
+ * touch a reference count, and it can be used anywhere a @c const_shared_buffer can,
+ * such as in a @c shared_buffer_sequence.
+ *
+ * @note The bytes are not owned, so they must outlive every @c const_shared_buffer
+ * referring to them. This is always true for objects with static storage duration,
+ * which is the intended use.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef STATIC_SHARED_BUFFER_HPP_INCLUDED
+#define STATIC_SHARED_BUFFER_HPP_INCLUDED
+
+#include <cstddef> // std::byte, std::size_t
+#include <array>
+#include <span>
+#include <memory> // std::shared_ptr
+
+#include "buffer/shared_buffer.hpp"
+
+namespace chops {
+
+/**
+ * @brief Create a @c const_shared_buffer referring to bytes that are not owned, such as
+ * bytes in static storage, without allocating.
+ *
+ * @pre The bytes must outlive the returned @c const_shared_buffer and all copies and
+ * slices of it, and must not be modified.
+ *
+ * @param sp Bytes to refer to.
+ */
+template <std::size_t Ext>
+const_shared_buffer make_static_shared_buffer(std::span<const std::byte, Ext> sp) noexcept {
+  return const_shared_buffer(std::shared_ptr<const std::byte>(std::shared_ptr<const std::byte>(),
+                                                              sp.data()), sp.size());
+}
+
+/**
+ * @brief A fixed size byte buffer that can be constructed at compile time, and shared as a
+ * @c const_shared_buffer without allocating.
+ *
+ * @tparam N Number of bytes.
+ */
+template <std::size_t N>
+class static_shared_buffer {
+public:
+  using size_type = std::size_t;
+
+private:
+  std::array<std::byte, N> m_bytes;
+
+public:
+
+/**
+ * @brief Construct from a @c std::array of @c std::byte.
+ */
+  constexpr explicit static_shared_buffer(const std::array<std::byte, N>& arr) noexcept :
+      m_bytes(arr) { }
+
+/**
+ * @brief Construct from a string literal, without the terminating null character.
+ *
+ * The class template argument is deduced, so @c static_shared_buffer { "OK" } holds
+ * two bytes.
+ */
+  constexpr static_shared_buffer(const char (&str)[N + 1u]) noexcept : m_bytes() {
+    for (size_type i = 0u; i < N; ++i) {
+      m_bytes[i] = static_cast<std::byte>(str[i]);
+    }
+  }
+
+  constexpr const std::byte* data() const noexcept { return m_bytes.data(); }
+  constexpr size_type size() const noexcept { return N; }
+  constexpr bool empty() const noexcept { return N == 0u; }
+
+/**
+ * @brief Return the bytes as a @c std::span.
+ */
+  constexpr std::span<const std::byte, N> span() const noexcept { return std::span<const std::byte, N>(m_bytes); }
+
+/**
+ * @brief Return a @c const_shared_buffer referring to the bytes, without allocating.
+ *
+ * @pre This object must outlive the returned @c const_shared_buffer (and its copies),
+ * which is always true when it has static storage duration.
+ */
+  const_shared_buffer share() const noexcept { return make_static_shared_buffer(span()); }
+
+  constexpr bool operator==(const static_shared_buffer&) const noexcept = default;
+
+};
+
+template <std::size_t N>
+static_shared_buffer(const char (&)[N]) -> static_shared_buffer<N - 1u>;
+
+template <std::size_t N>
+static_shared_buffer(const std::array<std::byte, N>&) -> static_shared_buffer<N>;
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,87 @@
+/** @file
+ *
+ * @brief Test scenarios for @c aligned_allocator class.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <cstdint> // std::uintptr_t
+#include <memory> // std::allocator_arg
+#include <span>
+#include <utility> // std::move
+
+#include "buffer/aligned_allocator.hpp"
+#include "buffer/shared_buffer.hpp"
+
+#include "utility/repeat.hpp"
+#include "utility/byte_array.hpp"
+
+namespace {
+
+bool is_aligned(const std::byte* p, std::size_t align) {
+  return reinterpret_cast<std::uintptr_t>(p) % align == 0u;
+}
+
+}
+
+TEST_CASE ( "Aligned mutable shared buffer",
+            "[aligned_allocator] [mutable_shared_buffer]" ) {
+
+  auto arr = chops::make_byte_array (0x01, 0x02, 0x03);
+
+  chops::aligned_mutable_shared_buffer<64u> msb(10u);
+  REQUIRE (is_aligned(msb.data(), 64u));
+  chops::repeat(100, [&msb, &arr] { msb.append(arr.data(), arr.size()); } ); // reallocations
+  REQUIRE (msb.size() == 310u);
+  REQUIRE (is_aligned(msb.data(), 64u));
+
+  chops::aligned_mutable_shared_buffer<4096u> page_buf(arr.data(), arr.size());
+  REQUIRE (is_aligned(page_buf.data(), 4096u));
+
+  SECTION ( "Move into a const shared buffer keeps the alignment, however small" ) {
+    chops::const_shared_buffer csb(std::move(page_buf));
+    REQUIRE (is_aligned(csb.data(), 4096u));
+    REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+  }
+  SECTION ( "Copy into a const shared buffer keeps the alignment" ) {
+    chops::const_shared_buffer csb(msb);
+    REQUIRE (is_aligned(csb.data(), 64u));
+    REQUIRE (csb == msb);
+  }
+}
+
+TEST_CASE ( "Aligned const shared buffer",
+            "[aligned_allocator] [const_shared_buffer]" ) {
+
+  auto arr = chops::make_byte_array (0x01, 0x02, 0x03, 0x04, 0x05);
+
+  chops::const_shared_buffer csb(std::allocator_arg, chops::aligned_allocator<std::byte, 256u>(), 
+                                 std::span<const std::byte>(arr));
+  REQUIRE (is_aligned(csb.data(), 256u));
+  REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+}
+
+TEST_CASE ( "Huge page mutable shared buffer",
+            "[aligned_allocator] [huge_page]" ) {
+
+  chops::huge_page_mutable_shared_buffer small(100u);
+  REQUIRE (is_aligned(small.data(), 4096u));
+
+  chops::huge_page_mutable_shared_buffer big(chops::huge_page_size + 1u);
+  REQUIRE (is_aligned(big.data(), chops::huge_page_size));
+  REQUIRE (big.size() == chops::huge_page_size + 1u);
+  big.data()[chops::huge_page_size] = std::byte{0x7f};
+  big.resize(10u);
+  big.shrink_to_fit();
+  REQUIRE (is_aligned(big.data(), 4096u));
+}
+
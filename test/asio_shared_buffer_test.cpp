@@ -0,0 +1,189 @@
+/** @file
+ *
+ * @brief Test scenarios for the Asio adapters of the @c shared_buffer classes.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte, std::size_t
+#include <cstring> // std::memcpy
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm> // std::min
+#include <utility> // std::move
+
+#include "buffer/asio_shared_buffer.hpp"
+#include "buffer/shared_buffer.hpp"
+#include "buffer/shared_buffer_sequence.hpp"
+
+#if !defined(SHARED_BUFFER_USE_BOOST_ASIO) && __has_include(<asio/read_until.hpp>)
+#include "asio/read_until.hpp"
+#else
+#include <boost/asio/read_until.hpp>
+#endif
+
+namespace net = chops::detail::asio_ns;
+
+using error_code = decltype(net::error::make_error_code(net::error::eof));
+
+namespace {
+
+chops::const_shared_buffer make_csb(std::string_view str) {
+  return chops::const_shared_buffer(str.data(), str.size());
+}
+
+std::string str_of(std::span<const std::byte> sp) {
+  return std::string(reinterpret_cast<const char*>(sp.data()), sp.size());
+}
+
+// SyncReadStream handing out the input a few bytes at a time
+struct chunked_stream {
+  std::string m_input;
+  std::size_t m_chunk;
+  std::size_t m_pos { 0u };
+
+  template <typename MutableBufferSequence>
+  std::size_t read_some(const MutableBufferSequence& bufs, error_code& ec) {
+    ec = error_code();
+    if (m_pos == m_input.size()) {
+      ec = net::error::eof;
+      return 0u;
+    }
+    auto n { net::buffer_copy(bufs, net::buffer(m_input.data() + m_pos,
+                                                 (std::min)(m_chunk, m_input.size() - m_pos))) };
+    m_pos += n;
+    return n;
+  }
+};
+
+template <typename Buf>
+void read_lines_test(chops::dynamic_shared_buffer<Buf>& dbuf, std::size_t chunk) {
+  chunked_stream strm { "first line\nsecond\nthird and last line\n", chunk };
+  std::vector<std::string> lines;
+  error_code ec;
+  while (true) {
+    auto n { net::read_until(strm, chops::asio_dynamic_buffer(dbuf), '\n', ec) };
+    if (ec) {
+      break;
+    }
+    lines.push_back(str_of(dbuf.readable().first(n - 1u)));
+    dbuf.consume(n);
+  }
+  REQUIRE (ec == net::error::eof);
+  REQUIRE (lines == std::vector<std::string> { "first line", "second", "third and last line" });
+  REQUIRE (dbuf.size() == 0u);
+}
+
+}
+
+TEST_CASE ( "Asio buffer conversions",
+            "[asio_buffer]" ) {
+
+  static_assert(net::is_const_buffer_sequence<chops::asio_buffer_sequence>::value);
+  static_assert(net::is_dynamic_buffer_v1<chops::dynamic_shared_buffer_ref<chops::mutable_shared_buffer>>::value);
+  static_assert(net::is_dynamic_buffer_v2<chops::dynamic_shared_buffer_ref<chops::mutable_shared_buffer>>::value);
+
+  auto csb { make_csb("Hello") };
+  net::const_buffer cb { chops::asio_buffer(csb) };
+  REQUIRE (cb.data() == csb.data());
+  REQUIRE (cb.size() == csb.size());
+
+  chops::mutable_shared_buffer msb(csb.data(), csb.size());
+  net::mutable_buffer mb { chops::asio_buffer(msb) };
+  REQUIRE (mb.data() == msb.data());
+  REQUIRE (mb.size() == 5u);
+  const auto& cmsb { msb };
+  net::const_buffer cb2 { chops::asio_buffer(cmsb) };
+  REQUIRE (cb2.data() == msb.data());
+}
+
+TEST_CASE ( "Asio buffer sequence of shared buffer segments",
+            "[asio_buffer_sequence]" ) {
+
+  chops::shared_buffer_sequence seq { make_csb("Hello"), make_csb(", "), make_csb("world") };
+  auto bufs { chops::asio_buffers(seq) };
+  REQUIRE (net::buffer_size(bufs) == seq.total_size());
+  REQUIRE (std::distance(net::buffer_sequence_begin(bufs), net::buffer_sequence_end(bufs)) == 3);
+  REQUIRE ((*bufs.begin()).data() == seq[0].data()); // no copy
+
+  std::string out(seq.total_size(), ' ');
+  REQUIRE (net::buffer_copy(net::buffer(out), bufs) == seq.total_size());
+  REQUIRE (out == "Hello, world");
+
+  seq.clear();
+  REQUIRE (net::buffer_size(bufs) == 12u); // segments are held by the adapter
+
+  auto one { chops::asio_buffers(make_csb("abc")) };
+  REQUIRE (net::buffer_size(one) == 3u);
+}
+
+TEST_CASE ( "Dynamic shared buffer",
+            "[dynamic_shared_buffer]" ) {
+
+  SECTION ( "Prepare, commit, and consume" ) {
+    chops::dynamic_shared_buffer dbuf;
+    REQUIRE (dbuf.size() == 0u);
+    auto sp { dbuf.prepare(10u) };
+    REQUIRE (sp.size() == 10u);
+    std::memcpy(sp.data(), "abcdefghij", 10u);
+    dbuf.commit(6u);
+    REQUIRE (str_of(dbuf.readable()) == "abcdef");
+    dbuf.consume(2u);
+    REQUIRE (str_of(dbuf.readable()) == "cdef");
+    auto p { dbuf.readable().data() };
+    auto sp2 { dbuf.prepare(4u) }; // fits in the high water mark, no move or fill
+    REQUIRE (dbuf.readable().data() == p);
+    REQUIRE (str_of(sp2) == "ghij");
+    dbuf.prepare(6u); // front space reused, readable bytes moved to the front
+    REQUIRE (dbuf.readable().data() == sp.data());
+    REQUIRE (str_of(dbuf.readable()) == "cdef");
+    dbuf.consume(10u);
+    REQUIRE (dbuf.size() == 0u);
+    REQUIRE (dbuf.prepare(10u).data() == sp.data());
+  }
+  SECTION ( "Maximum size" ) {
+    chops::dynamic_shared_buffer dbuf(8u);
+    dbuf.prepare(8u);
+    dbuf.commit(8u);
+    REQUIRE_THROWS_AS (dbuf.prepare(1u), std::length_error);
+    dbuf.shrink(3u);
+    REQUIRE (dbuf.size() == 5u);
+  }
+  SECTION ( "Asio read_until, one byte at a time" ) {
+    chops::dynamic_shared_buffer dbuf;
+    read_lines_test(dbuf, 1u);
+  }
+  SECTION ( "Asio read_until, large reads" ) {
+    chops::dynamic_shared_buffer<chops::cow_mutable_shared_buffer> dbuf;
+    read_lines_test(dbuf, 100u);
+  }
+  SECTION ( "Asio read_until, growing without a zero fill" ) {
+    chops::dynamic_shared_buffer<chops::basic_mutable_shared_buffer<
+                                   chops::default_init_allocator<std::byte>>> dbuf;
+    read_lines_test(dbuf, 3u);
+  }
+  SECTION ( "Asio v1 dynamic buffer interface" ) {
+    chops::dynamic_shared_buffer dbuf(chops::mutable_shared_buffer(make_csb("xy").data(), 2u));
+    auto ref { chops::asio_dynamic_buffer(dbuf) };
+    auto mb { ref.prepare(3u) };
+    std::memcpy(mb.data(), "123", 3u);
+    ref.commit(3u);
+    REQUIRE (net::buffer_size(ref.data()) == 5u);
+    REQUIRE (str_of(dbuf.readable()) == "xy123");
+    ref.grow(2u);
+    REQUIRE (ref.data(4u, 10u).size() == 3u);
+    ref.shrink(2u);
+    ref.consume(1u);
+    REQUIRE (str_of(dbuf.readable()) == "y123");
+  }
+}
+
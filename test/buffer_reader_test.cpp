@@ -0,0 +1,84 @@
+/** @file
+ *
+ * @brief Test scenarios for @c buffer_reader class and the typed append methods of
+ * @c mutable_shared_buffer.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <cstdint> // std::uint16_t, etc
+#include <utility> // std::move
+
+#include "buffer/buffer_reader.hpp"
+#include "buffer/shared_buffer.hpp"
+
+#include "utility/byte_array.hpp"
+
+namespace {
+
+template <typename... Bs>
+chops::mutable_shared_buffer make_buf(Bs... bs) {
+  auto arr { chops::make_byte_array(bs...) };
+  return chops::mutable_shared_buffer(arr.cbegin(), arr.cend());
+}
+
+}
+
+TEST_CASE ( "Mutable shared buffer typed append",
+            "[mutable_shared_buffer] [append_val]" ) {
+
+  chops::mutable_shared_buffer msb;
+
+  SECTION ( "Big endian" ) {
+    msb.append_be(std::uint16_t(0x0102), std::uint32_t(0x03040506));
+    msb.append_be<std::uint8_t>(0x07);
+    REQUIRE (msb == make_buf(0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07));
+  }
+  SECTION ( "Little endian" ) {
+    msb.append_le<std::uint16_t, std::int32_t>(0x0102, -2);
+    REQUIRE (msb == make_buf(0x02, 0x01, 0xfe, 0xff, 0xff, 0xff));
+  }
+  SECTION ( "Network byte order and chaining" ) {
+    msb.append_val<std::uint16_t>(0x0a0b).append_val(std::uint64_t(1u));
+    REQUIRE (msb == make_buf(0x0a, 0x0b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01));
+  }
+}
+
+TEST_CASE ( "Buffer reader",
+            "[buffer_reader]" ) {
+
+  chops::mutable_shared_buffer msb;
+  msb.append_be(std::uint16_t(0xbeef), std::int32_t(-5), 2.5);
+  msb.append_le(std::uint64_t(0x0102030405060708u), 1.25f);
+  msb.append(make_buf(0xaa, 0xbb, 0xcc));
+  chops::const_shared_buffer csb(std::move(msb));
+
+  chops::buffer_reader rdr(csb);
+  REQUIRE (rdr.remaining() == csb.size());
+  REQUIRE (rdr.read_be<std::uint16_t>() == 0xbeef);
+  REQUIRE (rdr.read_val<std::int32_t>() == -5);
+  REQUIRE (rdr.read_be<double>() == 2.5);
+  REQUIRE (rdr.position() == 14u);
+  REQUIRE (rdr.read_le<std::uint64_t>() == 0x0102030405060708u);
+  REQUIRE (rdr.read_le<float>() == 1.25f);
+  REQUIRE (rdr.remaining_bytes().size() == 3u);
+  rdr.skip(1u);
+  auto sp { rdr.read_bytes(2u) };
+  REQUIRE (sp.size() == 2u);
+  REQUIRE (sp[0] == std::byte{0xbb});
+  REQUIRE (sp[1] == std::byte{0xcc});
+  REQUIRE (rdr.empty());
+  rdr.reset();
+  REQUIRE (rdr.position() == 0u);
+  REQUIRE (rdr.read_le<std::uint16_t>() == 0xefbe);
+}
+
@@ -0,0 +1,136 @@
+/** @file
+ *
+ * @brief Test scenarios for @c local_mutable_shared_buffer and
+ * @c local_const_shared_buffer classes.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <vector>
+#include <list>
+#include <utility> // std::move
+#include <optional>
+
+#include "buffer/local_shared_buffer.hpp"
+#include "buffer/shared_buffer.hpp"
+
+#include "utility/byte_array.hpp"
+
+TEST_CASE ( "Local mutable shared buffer, non-atomic reference count",
+            "[local_mutable_shared_buffer]" ) {
+
+  auto arr = chops::make_byte_array (0x01, 0x02, 0x03, 0x04);
+
+  chops::local_mutable_shared_buffer lmsb(arr.data(), arr.size());
+  REQUIRE (lmsb.size() == arr.size());
+  REQUIRE (lmsb.use_count() == 1);
+  {
+    auto lmsb2 { lmsb };
+    REQUIRE (lmsb.use_count() == 2);
+    lmsb2.append(arr.data(), arr.size());
+    REQUIRE (lmsb.size() == 2u * arr.size()); // same internal buffer
+  }
+  REQUIRE (lmsb.use_count() == 1);
+
+  chops::local_mutable_shared_buffer lmsb3;
+  REQUIRE (lmsb3.empty());
+  lmsb3.swap(lmsb);
+  REQUIRE (lmsb.empty());
+  REQUIRE (lmsb3.size() == 2u * arr.size());
+  lmsb3.resize(2u);
+  REQUIRE (lmsb3 == chops::local_mutable_shared_buffer(arr.data(), 2u));
+
+  SECTION ( "Convert to thread-safe mutable shared buffer, moving the bytes" ) {
+    const std::byte* ptr = lmsb3.data();
+    chops::mutable_shared_buffer msb { chops::to_shared(std::move(lmsb3)) };
+    REQUIRE (msb.data() == ptr);
+    REQUIRE (msb.size() == 2u);
+    REQUIRE (lmsb3.empty());
+  }
+  SECTION ( "Convert to thread-safe mutable shared buffer, copying shared bytes" ) {
+    auto lmsb4 { lmsb3 };
+    chops::mutable_shared_buffer msb { chops::to_shared(std::move(lmsb3)) };
+    REQUIRE (msb.data() != lmsb4.data());
+    REQUIRE (msb.size() == lmsb4.size());
+    REQUIRE (lmsb3.size() == lmsb4.size());
+  }
+}
+
+TEST_CASE ( "Local const shared buffer, non-atomic reference count",
+            "[local_const_shared_buffer]" ) {
+
+  auto arr = chops::make_byte_array (0x01, 0x02, 0x03, 0x04, 0x05, 0x06);
+  auto arr2 = chops::make_byte_array (0x02, 0x03);
+
+  chops::local_const_shared_buffer lcsb(arr.data(), arr.size());
+  REQUIRE (lcsb.size() == arr.size());
+  REQUIRE (lcsb == chops::local_const_shared_buffer(arr.cbegin(), arr.cend()));
+  REQUIRE (lcsb < chops::local_const_shared_buffer(arr2.cbegin(), arr2.cend()));
+
+  std::list<std::byte> lst(arr.cbegin(), arr.cend());
+  REQUIRE (lcsb == chops::local_const_shared_buffer(lst.cbegin(), lst.cend()));
+
+  SECTION ( "Slices share the bytes and keep them alive" ) {
+    std::optional<chops::local_const_shared_buffer> opt { std::in_place, arr.data(), arr.size() };
+    auto sl { opt->slice(1u, 2u) };
+    REQUIRE (sl.data() == opt->data() + 1);
+    opt.reset();
+    REQUIRE (sl == chops::local_const_shared_buffer(arr2.cbegin(), arr2.cend()));
+    REQUIRE (sl.slice(2u).empty());
+  }
+  SECTION ( "Move a large local mutable shared buffer without copying" ) {
+    chops::local_mutable_shared_buffer lmsb(chops::local_const_shared_buffer::inline_size + 1u);
+    const std::byte* ptr = lmsb.data();
+    chops::local_const_shared_buffer lcsb2(std::move(lmsb));
+    REQUIRE (lcsb2.data() == ptr);
+    REQUIRE (lmsb.empty());
+  }
+  SECTION ( "Move a small local mutable shared buffer, capacity is kept" ) {
+    chops::local_mutable_shared_buffer lmsb(arr.data(), arr.size());
+    chops::local_const_shared_buffer lcsb2(std::move(lmsb));
+    REQUIRE (lcsb2 == lcsb);
+    REQUIRE (lmsb.empty());
+    REQUIRE (lmsb.capacity() >= arr.size());
+  }
+  SECTION ( "Move a shared local mutable shared buffer, bytes are copied" ) {
+    chops::local_mutable_shared_buffer lmsb(chops::local_const_shared_buffer::inline_size + 1u);
+    auto lmsb2 { lmsb };
+    chops::local_const_shared_buffer lcsb2(std::move(lmsb));
+    REQUIRE (lcsb2.data() != lmsb2.data());
+    lmsb2.append(arr.data(), arr.size());
+    REQUIRE (lcsb2.size() == chops::local_const_shared_buffer::inline_size + 1u);
+  }
+  SECTION ( "Move a vector of bytes" ) {
+    std::vector<std::byte> bv(chops::local_const_shared_buffer::inline_size + 1u);
+    const std::byte* ptr = bv.data();
+    chops::local_const_shared_buffer lcsb2(std::move(bv));
+    REQUIRE (lcsb2.data() == ptr);
+    REQUIRE (bv.empty());
+  }
+  SECTION ( "Convert to thread-safe const shared buffer, transferring ownership" ) {
+    const std::byte* ptr = lcsb.data();
+    chops::const_shared_buffer csb { chops::to_shared(std::move(lcsb)) };
+    REQUIRE (csb.data() == ptr);
+    REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+    auto csb2 { csb };
+    REQUIRE (csb2.data() == ptr);
+  }
+  SECTION ( "Convert to thread-safe const shared buffer, copying shared bytes" ) {
+    auto sl { lcsb.slice(1u) };
+    chops::const_shared_buffer csb { chops::to_shared(std::move(lcsb)) };
+    REQUIRE (csb.data() != lcsb.data());
+    REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+    chops::const_shared_buffer csb2 { chops::to_shared(sl) };
+    REQUIRE (csb2.size() == arr.size() - 1u);
+  }
+}
+
@@ -0,0 +1,67 @@
+/** @file
+ *
+ * @brief Test scenarios for @c map_file function.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <optional>
+#include <vector>
+
+#include "buffer/map_file.hpp"
+#include "buffer/shared_buffer.hpp"
+
+TEST_CASE ( "Map a file into a const shared buffer",
+            "[map_file]" ) {
+
+  namespace fs = std::filesystem;
+
+  const auto path { fs::temp_directory_path() / "shared_buffer_map_file_test.bin" };
+  const auto empty_path { fs::temp_directory_path() / "shared_buffer_map_file_test_empty.bin" };
+
+  std::vector<std::byte> contents;
+  for (int i = 0; i < 10000; ++i) {
+    contents.push_back(static_cast<std::byte>(i % 251));
+  }
+  {
+    std::ofstream ofs(path, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+    std::ofstream ofs2(empty_path, std::ios::binary);
+  }
+
+  SECTION ( "Whole file is mapped, slices keep the mapping alive" ) {
+    std::optional<chops::const_shared_buffer> csb { chops::map_file(path) };
+    REQUIRE (csb->size() == contents.size());
+    REQUIRE (*csb == chops::const_shared_buffer(contents.data(), contents.size()));
+    auto sl { csb->slice(5000u, 100u) };
+    auto cpy { *csb };
+    REQUIRE (cpy.data() == csb->data());
+    csb.reset();
+    REQUIRE (sl.data() == cpy.data() + 5000);
+    REQUIRE (sl == chops::const_shared_buffer(contents.data() + 5000, 100u));
+  }
+  SECTION ( "Empty file results in an empty buffer" ) {
+    auto csb { chops::map_file(empty_path) };
+    REQUIRE (csb.empty());
+  }
+  SECTION ( "Missing file throws" ) {
+    REQUIRE_THROWS_AS (chops::map_file(fs::temp_directory_path() / "shared_buffer_no_such_file.bin"),
+                       std::system_error);
+  }
+
+  fs::remove(path);
+  fs::remove(empty_path);
+}
+
@@ -0,0 +1,96 @@
+/** @file
+ *
+ * @brief Test scenarios for @c registered_buffer_region class.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <cstdint> // std::uintptr_t
+#include <array>
+#include <vector>
+#include <span>
+#include <utility> // std::move
+
+#include "buffer/registered_buffer_region.hpp"
+#include "buffer/shared_buffer.hpp"
+
+#include "utility/byte_array.hpp"
+
+// same layout as the POSIX iovec, without requiring the POSIX header
+struct test_iovec {
+  void* iov_base;
+  std::size_t iov_len;
+};
+
+TEST_CASE ( "Registered buffer region slots",
+            "[registered_buffer_region]" ) {
+
+  auto arr = chops::make_byte_array (0xaa, 0xbb, 0xcc, 0xdd);
+
+  chops::registered_buffer_region region(1000u, 4u);
+  REQUIRE (region.slot_size() == 4096u);
+  REQUIRE (region.slot_count() == 4u);
+  REQUIRE (region.free_slots() == 4u);
+  REQUIRE (reinterpret_cast<std::uintptr_t>(region.data()) % 4096u == 0u);
+
+  std::array<test_iovec, 8> iovs { };
+  REQUIRE (region.fill_io_vectors(std::span<test_iovec>(iovs)) == 4u);
+  REQUIRE (iovs[1].iov_base == static_cast<const void*>(region.data() + 4096));
+  REQUIRE (iovs[3].iov_len == 4096u);
+
+  SECTION ( "Buffers use slots, released when the last reference goes away" ) {
+    {
+      auto buf { region.make_buffer(100u) };
+      REQUIRE (buf.size() == 100u);
+      REQUIRE (region.free_slots() == 3u);
+      auto idx { region.buffer_index(buf.data()) };
+      REQUIRE (idx);
+      REQUIRE (static_cast<const void*>(buf.data()) == iovs[*idx].iov_base);
+      buf.append(arr.data(), arr.size());
+      REQUIRE (region.buffer_index(buf.data()) == idx); // stays in the slot
+    }
+    REQUIRE (region.free_slots() == 4u);
+  }
+  SECTION ( "Handoff to a const shared buffer keeps the bytes in the slot" ) {
+    auto buf { region.make_buffer() };
+    buf.append(arr.data(), arr.size()); // small, but not copied out of the slot
+    auto idx { region.buffer_index(buf.data()) };
+    chops::const_shared_buffer csb(std::move(buf));
+    REQUIRE (region.buffer_index(csb.data()) == idx);
+    REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+    auto sl { csb.slice(2u) };
+    REQUIRE (region.buffer_index(sl.data()) == idx);
+    REQUIRE (region.free_slots() == 3u);
+    chops::const_shared_buffer cpy(region.make_buffer(10u)); // copying a temporary buffer
+    REQUIRE (region.free_slots() == 2u);
+  }
+  SECTION ( "Copying a registered buffer does not use a slot" ) {
+    auto buf { region.make_buffer(10u) };
+    chops::const_shared_buffer csb(buf);
+    REQUIRE_FALSE (region.buffer_index(csb.data()));
+    REQUIRE (region.free_slots() == 3u);
+  }
+  SECTION ( "Exhausted or oversize buffers are not in the region" ) {
+    std::vector<chops::registered_mutable_shared_buffer> bufs;
+    for (int i = 0; i < 4; ++i) {
+      bufs.push_back(region.make_buffer(10u));
+    }
+    REQUIRE (region.free_slots() == 0u);
+    auto extra { region.make_buffer(10u) };
+    REQUIRE_FALSE (region.buffer_index(extra.data()));
+    bufs.pop_back();
+    auto big { region.make_buffer(region.slot_size() + 1u) };
+    REQUIRE_FALSE (region.buffer_index(big.data()));
+    REQUIRE (region.free_slots() == 1u);
+  }
+}
+
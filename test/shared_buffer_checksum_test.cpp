@@ -0,0 +1,151 @@
+/** @file
+ *
+ * @brief Test scenarios for the CRC32C and Adler-32 checksum functions and classes.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte, std::size_t
+#include <cstdint> // std::uint32_t
+#include <string_view>
+#include <vector>
+#include <array>
+#include <span>
+#include <utility> // std::move
+#include <algorithm> // std::equal
+
+#include "buffer/shared_buffer_checksum.hpp"
+#include "buffer/shared_buffer.hpp"
+#include "buffer/shared_buffer_sequence.hpp"
+
+namespace {
+
+std::span<const std::byte> bytes_of(std::string_view str) {
+  return std::as_bytes(std::span<const char>(str.data(), str.size()));
+}
+
+std::vector<std::byte> make_bytes(std::size_t sz) {
+  std::vector<std::byte> vec(sz);
+  for (std::size_t i = 0u; i < sz; ++i) {
+    vec[i] = static_cast<std::byte>((i * 131u) ^ (i >> 5));
+  }
+  return vec;
+}
+
+}
+
+TEST_CASE ( "CRC32C and Adler-32 values",
+            "[checksum]" ) {
+
+  REQUIRE (chops::crc32c(bytes_of("123456789")) == 0xE3069283u);
+  REQUIRE (chops::crc32c(std::array<std::byte, 32u> { }) == 0x8A9136AAu); // RFC 3720
+  REQUIRE (chops::crc32c(std::span<const std::byte>()) == 0u);
+  REQUIRE (chops::adler32(bytes_of("Wikipedia")) == 0x11E60398u);
+  REQUIRE (chops::adler32(std::span<const std::byte>()) == 1u);
+
+  auto bytes { make_bytes(10000u) };
+  // hardware instructions, when enabled, give the same result as the table version
+  REQUIRE (chops::crc32c(bytes) == ~chops::detail::crc32c_sw(~0u, bytes.data(), bytes.size()));
+
+  chops::const_shared_buffer csb(bytes.data(), bytes.size());
+  chops::mutable_shared_buffer msb(bytes.data(), bytes.size());
+  REQUIRE (chops::crc32c(csb) == chops::crc32c(bytes));
+  REQUIRE (chops::crc32c(msb) == chops::crc32c(bytes));
+}
+
+TEST_CASE ( "Checksum continuation and combination",
+            "[checksum]" ) {
+
+  auto bytes { make_bytes(7001u) };
+  std::span<const std::byte> all { bytes };
+  for (std::size_t split : { 0u, 1u, 7u, 8u, 4000u, 7001u }) {
+    auto first { all.first(split) };
+    auto second { all.subspan(split) };
+    REQUIRE (chops::crc32c(second, chops::crc32c(first)) == chops::crc32c(all));
+    REQUIRE (chops::crc32c_combine(chops::crc32c(first), chops::crc32c(second), second.size()) ==
+             chops::crc32c(all));
+    REQUIRE (chops::adler32(second, chops::adler32(first)) == chops::adler32(all));
+    REQUIRE (chops::adler32_combine(chops::adler32(first), chops::adler32(second), second.size()) ==
+             chops::adler32(all));
+  }
+
+  chops::crc32c_checksum a;
+  chops::crc32c_checksum b;
+  a.update(all.first(100u));
+  b.update(all.subspan(100u));
+  REQUIRE (a.combine(b).value() == chops::crc32c(all));
+  REQUIRE (a.size() == all.size());
+
+  chops::adler32_checksum c;
+  c.update(all.first(3u)).update(all.subspan(3u));
+  REQUIRE (c.value() == chops::adler32(all));
+}
+
+TEST_CASE ( "Checksum while appending, and cached with a const shared buffer",
+            "[checksum] [checksummed_buffer]" ) {
+
+  auto hdr { make_bytes(12u) };
+  auto body { make_bytes(3000u) };
+  chops::mutable_shared_buffer msb;
+  chops::crc32c_checksum ck;
+  chops::append_checksummed(msb, ck, hdr, body);
+  chops::append_checksummed(msb, ck, std::span<const std::byte>(hdr).first(4u));
+  REQUIRE (msb.size() == 3016u);
+  REQUIRE (ck.size() == msb.size());
+  REQUIRE (ck.value() == chops::crc32c(msb));
+
+  // several MiB, copied and checksummed in cache sized blocks
+  auto big { make_bytes(5u * 1024u * 1024u + 7u) };
+  chops::mutable_shared_buffer big_msb(hdr.data(), hdr.size());
+  chops::crc32c_checksum big_ck;
+  chops::adler32_checksum big_ad;
+  chops::append_checksummed(big_msb, big_ck, big, hdr, big);
+  chops::mutable_shared_buffer big_msb2;
+  chops::append_checksummed(big_msb2, big_ad, big);
+  std::vector<std::byte> flat(big);
+  flat.insert(flat.end(), hdr.begin(), hdr.end());
+  flat.insert(flat.end(), big.begin(), big.end());
+  REQUIRE (big_msb.size() == hdr.size() + flat.size());
+  REQUIRE (std::equal(flat.begin(), flat.end(), big_msb.data() + hdr.size()));
+  REQUIRE (big_ck.value() == chops::crc32c(flat));
+  REQUIRE (big_ck.size() == flat.size());
+  REQUIRE (big_ad.value() == chops::adler32(big));
+
+  chops::checksummed_buffer cb(chops::const_shared_buffer(std::move(msb)), ck);
+  REQUIRE (cb.size() == 3016u);
+  REQUIRE (cb.checksum() == chops::crc32c(cb.buffer()));
+  REQUIRE (cb.verify());
+
+  chops::checksummed_buffer cb2(cb.buffer());
+  REQUIRE (cb2.checksum() == cb.checksum());
+  REQUIRE (cb2.data() == cb.data()); // shares the bytes
+}
+
+TEST_CASE ( "Parallel CRC32C over a buffer sequence",
+            "[checksum] [parallel]" ) {
+
+  auto big { make_bytes(300000u) };
+  auto small { make_bytes(17u) };
+  chops::shared_buffer_sequence seq;
+  seq.emplace_back(small.data(), small.size());
+  seq.emplace_back(big.data(), big.size());
+  seq.emplace_back(small.data(), small.size());
+  seq.emplace_back(small.data(), 0u);
+  seq.emplace_back(big.data(), 1000u);
+
+  auto expected { chops::crc32c(seq.flatten()) };
+  REQUIRE (chops::crc32c(seq) == expected);
+  REQUIRE (chops::parallel_crc32c(seq) == expected);
+  for (unsigned thrs : { 1u, 2u, 3u, 7u }) {
+    REQUIRE (chops::parallel_crc32c(seq, thrs, 1000u) == expected);
+  }
+  REQUIRE (chops::parallel_crc32c(chops::shared_buffer_sequence(), 4u, 1u) == 0u);
+}
@@ -0,0 +1,177 @@
+/** @file
+ *
+ * @brief Test scenarios for the compression and decompression functions, with the
+ * LZ4 and Zstandard codecs when they are available.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte, std::size_t
+#include <cstdint> // std::uint64_t
+#include <cstring> // std::memcpy
+#include <optional>
+#include <span>
+#include <vector>
+#include <algorithm> // std::copy
+#include <utility> // std::move
+
+#include "buffer/shared_buffer_compress.hpp"
+#include "buffer/shared_buffer.hpp"
+#include "buffer/shared_buffer_sequence.hpp"
+
+namespace {
+
+// a codec that stores the bytes after an 8 byte size header, for the generic functions
+struct stored_codec {
+  std::size_t compress_bound(chops::codec_pieces src) const noexcept {
+    return 8u + chops::detail::pieces_size(src);
+  }
+  std::size_t compress(chops::codec_pieces src, std::span<std::byte> dst) const {
+    std::uint64_t sz { chops::detail::pieces_size(src) };
+    std::memcpy(dst.data(), &sz, 8u);
+    auto p { dst.data() + 8u };
+    for (auto piece : src) {
+      p = std::copy(piece.begin(), piece.end(), p);
+    }
+    return 8u + sz;
+  }
+  std::optional<std::size_t> content_size(std::span<const std::byte> hdr) const {
+    if (hdr.size() < 8u) {
+      return std::nullopt;
+    }
+    std::uint64_t sz;
+    std::memcpy(&sz, hdr.data(), 8u);
+    return sz;
+  }
+  std::size_t decompress(chops::codec_pieces src, std::span<std::byte> dst) const {
+    std::size_t skip { 8u };
+    std::size_t n { 0u };
+    for (auto piece : src) {
+      auto sk { skip < piece.size() ? skip : piece.size() };
+      skip -= sk;
+      piece = piece.subspan(sk);
+      if (n + piece.size() > dst.size()) {
+        throw chops::compression_error("stored: output too small");
+      }
+      std::copy(piece.begin(), piece.end(), dst.data() + n);
+      n += piece.size();
+    }
+    return n;
+  }
+};
+
+static_assert(chops::compression_codec<stored_codec>);
+
+// compressible, but not trivially so
+std::vector<std::byte> make_bytes(std::size_t sz) {
+  std::vector<std::byte> vec(sz);
+  for (std::size_t i = 0u; i < sz; ++i) {
+    vec[i] = static_cast<std::byte>((i % 251u) < 200u ? (i / 64u) : (i * 7u));
+  }
+  return vec;
+}
+
+chops::shared_buffer_sequence split_into(const chops::const_shared_buffer& buf,
+                                         std::initializer_list<std::size_t> sizes) {
+  chops::shared_buffer_sequence seq;
+  std::size_t off { 0u };
+  for (auto sz : sizes) {
+    seq.push_back(buf.slice(off, sz));
+    off += sz;
+  }
+  seq.push_back(buf.slice(off, buf.size() - off));
+  return seq;
+}
+
+template <typename Codec>
+void round_trip_test(const Codec& codec) {
+  auto bytes { make_bytes(100000u) };
+  chops::const_shared_buffer orig(bytes.data(), bytes.size());
+
+  auto packed { chops::compress(codec, orig) };
+  REQUIRE (chops::decompress(codec, packed) == orig);
+  REQUIRE (chops::decompress(codec, packed, orig.size()) == orig);
+  REQUIRE_THROWS_AS (chops::decompress(codec, packed, orig.size() - 1u), chops::compression_error);
+
+  // a sequence is compressed as one stream, and decompressed from segments
+  auto seq { split_into(orig, { 5u, 1u, 40000u, 3u }) };
+  auto seq_packed { chops::compress(codec, seq) };
+  REQUIRE (chops::decompress(codec, seq_packed) == orig);
+  REQUIRE (chops::decompress(codec, split_into(seq_packed, { 20u, 1u, 7u })) == orig);
+
+  chops::mutable_shared_buffer msb(bytes.data(), 10u);
+  auto n { chops::compress_append(codec, seq, msb) };
+  REQUIRE (msb.size() == 10u + n);
+  REQUIRE (chops::decompress(codec, std::span<const std::byte>(msb.data() + 10u, n)) == orig);
+
+  chops::const_shared_buffer empty(bytes.data(), 0u);
+  REQUIRE (chops::decompress(codec, chops::compress(codec, empty)).empty());
+  REQUIRE (chops::decompress(codec, chops::compress(codec, empty), 1u).empty());
+  REQUIRE (chops::decompress(codec, chops::compress(codec, chops::shared_buffer_sequence { empty })).empty());
+}
+
+}
+
+TEST_CASE ( "Generic compression functions",
+            "[compress]" ) {
+
+  stored_codec codec;
+  round_trip_test(codec);
+
+  auto bytes { make_bytes(1000u) };
+  chops::const_shared_buffer orig(bytes.data(), bytes.size());
+  auto packed { chops::compress(codec, orig) };
+  REQUIRE (packed.size() == 1008u); // trimmed to the bytes written
+
+  chops::mutable_shared_buffer msb(bytes.data(), 4u);
+  struct failing_codec : stored_codec {
+    std::size_t compress(chops::codec_pieces, std::span<std::byte>) const {
+      throw chops::compression_error("failed");
+    }
+  };
+  REQUIRE_THROWS_AS (chops::compress_append(failing_codec { }, orig, msb), chops::compression_error);
+  REQUIRE (msb.size() == 4u); // left unchanged
+
+  // the size is not in the first segment, so a maximum size is needed
+  auto seq { split_into(packed, { 4u }) };
+  REQUIRE_THROWS_AS (chops::decompress(codec, seq), chops::compression_error);
+  REQUIRE (chops::decompress(codec, seq, 2000u) == orig);
+}
+
+#if defined(SHARED_BUFFER_HAS_LZ4)
+TEST_CASE ( "LZ4 compression",
+            "[compress] [lz4]" ) {
+
+  round_trip_test(chops::lz4_codec());
+  round_trip_test(chops::lz4_codec(9));
+
+  auto bytes { make_bytes(10000u) };
+  auto packed { chops::compress(chops::lz4_codec(), bytes) };
+  REQUIRE (packed.size() < bytes.size());
+  auto corrupt { chops::const_shared_buffer(packed.data(), packed.size() - 3u) };
+  REQUIRE_THROWS_AS (chops::decompress(chops::lz4_codec(), corrupt), chops::compression_error);
+}
+#endif
+
+#if defined(SHARED_BUFFER_HAS_ZSTD)
+TEST_CASE ( "Zstandard compression",
+            "[compress] [zstd]" ) {
+
+  round_trip_test(chops::zstd_codec());
+  round_trip_test(chops::zstd_codec(19));
+
+  auto bytes { make_bytes(10000u) };
+  auto packed { chops::compress(chops::zstd_codec(), bytes) };
+  REQUIRE (packed.size() < bytes.size());
+  auto corrupt { chops::const_shared_buffer(packed.data(), packed.size() - 3u) };
+  REQUIRE_THROWS_AS (chops::decompress(chops::zstd_codec(), corrupt), chops::compression_error);
+}
+#endif
@@ -0,0 +1,117 @@
+/** @file
+ *
+ * @brief Test scenarios for @c shared_buffer_pool class.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <memory> // std::make_unique
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <set>
+#include <utility> // std::move
+
+#include "buffer/shared_buffer_pool.hpp"
+#include "buffer/shared_buffer.hpp"
+
+#include "utility/byte_array.hpp"
+
+TEST_CASE ( "Shared buffer pool recycles storage",
+            "[shared_buffer_pool]" ) {
+
+  auto arr = chops::make_byte_array (0xaa, 0xbb, 0xcc, 0xdd);
+  chops::shared_buffer_pool pool;
+
+  SECTION ( "Storage is reused after the last mutable shared buffer goes away" ) {
+    const std::byte* ptr = nullptr;
+    {
+      auto msb { pool.make_buffer(100u) };
+      REQUIRE (msb.size() == 100u);
+      ptr = msb.data();
+    }
+    auto msb2 { pool.make_buffer(90u) };
+    REQUIRE (msb2.data() == ptr);
+  }
+  SECTION ( "Storage is reused after the last const shared buffer goes away" ) {
+    const std::byte* ptr = nullptr;
+    constexpr auto sz { chops::const_shared_buffer::inline_size + 100u }; // not copied on move
+    {
+      auto msb { pool.make_buffer(sz) };
+      chops::const_shared_buffer csb(std::move(msb));
+      chops::const_shared_buffer csb2(csb);
+      REQUIRE (csb2.size() == sz);
+      ptr = csb.data();
+    }
+    auto msb2 { pool.make_buffer(sz) };
+    REQUIRE (msb2.data() == ptr);
+  }
+  SECTION ( "Large buffers bypass the size classes" ) {
+    auto msb { pool.make_buffer(pool.max_block_size() + 1u) };
+    REQUIRE (msb.size() == pool.max_block_size() + 1u);
+    msb.append(arr.data(), arr.size());
+    REQUIRE (msb.size() == pool.max_block_size() + 1u + arr.size());
+  }
+}
+
+TEST_CASE ( "Shared buffer pool with buffers freed on another thread",
+            "[shared_buffer_pool] [thread]" ) {
+
+  constexpr int N = 200;
+  chops::shared_buffer_pool pool(chops::shared_buffer_pool::default_max_block_size, 8u);
+
+  std::vector<chops::const_shared_buffer> bufs;
+  std::set<const std::byte*> ptrs;
+  for (int i = 0; i < N; ++i) {
+    chops::const_shared_buffer csb(pool.make_buffer(512u));
+    ptrs.insert(csb.data());
+    bufs.push_back(std::move(csb));
+  }
+
+  std::thread thr ( [bufs = std::move(bufs)] () mutable { bufs.clear(); } );
+  thr.join();
+
+  int reused = 0;
+  std::vector<chops::pmr::mutable_shared_buffer> bufs2;
+  for (int i = 0; i < N; ++i) {
+    bufs2.push_back(pool.make_buffer(400u));
+    reused += ptrs.contains(bufs2.back().data()) ? 1 : 0;
+  }
+  REQUIRE (reused == N);
+}
+
+TEST_CASE ( "Shared buffer pool destroyed before thread caches are flushed",
+            "[shared_buffer_pool] [thread]" ) {
+
+  auto pool { std::make_unique<chops::shared_buffer_pool>() };
+  std::atomic<bool> freed { false };
+  std::atomic<bool> done { false };
+
+  auto msb { pool->make_buffer(64u) };
+  std::thread thr ( [msb = std::move(msb), &freed, &done] () mutable {
+      { 
+        auto tmp { std::move(msb) }; // storage goes to this thread's cache
+      }
+      freed = true;
+      while (!done) {
+        std::this_thread::yield();
+      }
+    } );
+  while (!freed) {
+    std::this_thread::yield();
+  }
+  pool.reset();
+  done = true;
+  thr.join(); // thread cache finds the pool gone and frees the blocks
+  REQUIRE_FALSE (pool);
+}
+
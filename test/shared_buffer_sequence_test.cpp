@@ -0,0 +1,119 @@
+/** @file
+ *
+ * @brief Test scenarios for @c shared_buffer_sequence class.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <array>
+#include <span>
+#include <utility> // std::move
+
+#include "buffer/shared_buffer_sequence.hpp"
+#include "buffer/shared_buffer.hpp"
+
+#include "utility/byte_array.hpp"
+
+// same layout as the POSIX iovec, without requiring the POSIX header
+struct test_iovec {
+  void* iov_base;
+  std::size_t iov_len;
+};
+
+TEST_CASE ( "Shared buffer sequence basic operations",
+            "[shared_buffer_sequence]" ) {
+
+  auto hdr = chops::make_byte_array (0x01, 0x02);
+  auto body = chops::make_byte_array (0x10, 0x11, 0x12, 0x13, 0x14);
+  auto trl = chops::make_byte_array (0xff);
+
+  chops::const_shared_buffer hdr_buf(hdr.data(), hdr.size());
+  chops::const_shared_buffer body_buf(body.data(), body.size());
+  chops::const_shared_buffer trl_buf(trl.data(), trl.size());
+
+  chops::shared_buffer_sequence seq;
+  REQUIRE (seq.empty());
+  REQUIRE (seq.total_size() == 0u);
+
+  seq.push_back(hdr_buf).push_back(body_buf).push_back(trl_buf);
+  REQUIRE (seq.size() == 3u);
+  REQUIRE (seq.total_size() == hdr.size() + body.size() + trl.size());
+  REQUIRE (seq[0].data() == hdr_buf.data());
+  REQUIRE (seq[1].data() == body_buf.data());
+  REQUIRE (seq[2].data() == trl_buf.data());
+
+  SECTION ( "Fill in IO vectors" ) {
+    std::array<test_iovec, 4> iovs { };
+    REQUIRE (seq.fill_io_vectors(std::span<test_iovec>(iovs)) == 3u);
+    REQUIRE (iovs[0].iov_base == hdr_buf.data());
+    REQUIRE (iovs[0].iov_len == hdr.size());
+    REQUIRE (iovs[2].iov_base == trl_buf.data());
+    REQUIRE (iovs[2].iov_len == trl.size());
+    std::array<test_iovec, 2> iovs2 { };
+    REQUIRE (seq.fill_io_vectors(std::span<test_iovec>(iovs2)) == 2u);
+  }
+  SECTION ( "Flatten into one const shared buffer" ) {
+    auto all = chops::make_byte_array (0x01, 0x02, 0x10, 0x11, 0x12, 0x13, 0x14, 0xff);
+    REQUIRE (seq.flatten() == chops::const_shared_buffer(all.cbegin(), all.cend()));
+    chops::shared_buffer_sequence seq2 { body_buf };
+    REQUIRE (seq2.flatten().data() == body_buf.data());
+  }
+  SECTION ( "Copy and move" ) {
+    chops::shared_buffer_sequence seq2(seq);
+    REQUIRE (seq2.size() == 3u);
+    REQUIRE (seq2[1].data() == body_buf.data());
+    chops::shared_buffer_sequence seq3(std::move(seq2));
+    REQUIRE (seq3.size() == 3u);
+    REQUIRE (seq3.total_size() == seq.total_size());
+    REQUIRE (seq2.empty());
+    seq2 = seq3;
+    REQUIRE (seq2.size() == 3u);
+    seq3 = std::move(seq2);
+    REQUIRE (seq3.size() == 3u);
+    seq3.append(seq3);
+    REQUIRE (seq3.size() == 6u);
+    REQUIRE (seq3[5].data() == trl_buf.data());
+    REQUIRE (seq3.total_size() == 2u * seq.total_size());
+  }
+  SECTION ( "Grow past the inline capacity" ) {
+    std::size_t total { seq.total_size() };
+    for (int i = 0; i < 10; ++i) {
+      seq.push_back(body_buf.slice(i % 5));
+      total += 5u - (i % 5);
+    }
+    REQUIRE (seq.size() == 13u);
+    REQUIRE (seq.total_size() == total);
+    REQUIRE (seq[0].data() == hdr_buf.data());
+    chops::shared_buffer_sequence seq2(std::move(seq));
+    REQUIRE (seq2.size() == 13u);
+    REQUIRE (seq.empty());
+    seq.push_back(trl_buf);
+    REQUIRE (seq.size() == 1u);
+    int cnt { 0 };
+    for (const auto& seg : seq2) {
+      cnt += seg.empty() ? 0 : 1;
+    }
+    REQUIRE (cnt == 13);
+  }
+  SECTION ( "Push back an element of the sequence when the inline storage is full" ) {
+    seq.push_back(body_buf);
+    REQUIRE (seq.size() == chops::shared_buffer_sequence::inline_capacity);
+    seq.push_back(seq[0]);
+    seq.emplace_back(seq[1]);
+    REQUIRE (seq.size() == 6u);
+    REQUIRE (seq[4] == hdr_buf);
+    REQUIRE (seq[4].data() == hdr_buf.data());
+    REQUIRE (seq[5] == body_buf);
+    REQUIRE (seq.total_size() == 2u * hdr.size() + 3u * body.size() + trl.size());
+  }
+}
+
@@ -0,0 +1,157 @@
+/** @file
+ *
+ * @brief Test scenarios for the allocation and lifetime statistics of the shared
+ * buffer classes.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#define SHARED_BUFFER_ENABLE_STATS
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <memory_resource>
+#include <vector>
+#include <list>
+#include <utility> // std::move
+#include <optional>
+
+#include "buffer/shared_buffer.hpp"
+#include "buffer/local_shared_buffer.hpp"
+
+#include "utility/byte_array.hpp"
+
+TEST_CASE ( "Shared buffer statistics",
+            "[shared_buffer_stats]" ) {
+
+  static_assert(chops::shared_buffer_stats_enabled);
+
+  auto arr { chops::make_byte_array(0x01, 0x02, 0x03, 0x04) };
+  auto base { chops::shared_buffer_stats_snapshot() };
+  chops::reset_shared_buffer_stats();
+
+  SECTION ( "Mutable buffer allocation and growth" ) {
+    {
+      chops::mutable_shared_buffer msb;
+      REQUIRE (chops::shared_buffer_stats_snapshot().allocations == 0u); // lazy creation
+      msb.reserve(8u);
+      auto st { chops::shared_buffer_stats_snapshot() };
+      REQUIRE (st.allocations == 1u);
+      REQUIRE (st.size_histogram[0] == 1u);
+      REQUIRE (st.live_buffers == base.live_buffers + 1u);
+      REQUIRE (st.live_bytes == base.live_bytes + msb.capacity());
+      msb.append(arr.data(), arr.size());
+      REQUIRE (chops::shared_buffer_stats_snapshot().reallocations == 0u);
+      msb.resize(1000u);
+      st = chops::shared_buffer_stats_snapshot();
+      REQUIRE (st.reallocations == 1u);
+      REQUIRE (st.live_bytes == base.live_bytes + msb.capacity());
+      REQUIRE (st.peak_live_bytes >= st.live_bytes);
+    }
+    auto st { chops::shared_buffer_stats_snapshot() };
+    REQUIRE (st.live_buffers == base.live_buffers);
+    REQUIRE (st.live_bytes == base.live_bytes);
+  }
+  SECTION ( "Copies and zero copy moves into a const buffer" ) {
+    chops::mutable_shared_buffer msb(1000u);
+    chops::const_shared_buffer cp(msb);
+    auto st { chops::shared_buffer_stats_snapshot() };
+    REQUIRE (st.deep_copies == 1u);
+    REQUIRE (st.bytes_copied == 1000u);
+    REQUIRE (st.allocations == 2u);
+    REQUIRE (st.size_histogram[6] == 2u); // up to 1024 bytes
+    std::optional<chops::const_shared_buffer> mv;
+    mv.emplace(std::move(msb));
+    st = chops::shared_buffer_stats_snapshot();
+    REQUIRE (st.zero_copy_moves == 1u);
+    REQUIRE (st.bytes_moved == 1000u);
+    REQUIRE (st.live_buffers == base.live_buffers + 2u);
+    auto rec { std::move(*mv).try_reclaim() };
+    REQUIRE (rec);
+    REQUIRE (chops::shared_buffer_stats_snapshot().zero_copy_moves == 2u);
+    mv.reset();
+    rec.reset();
+    st = chops::shared_buffer_stats_snapshot();
+    REQUIRE (st.live_buffers == base.live_buffers + 1u); // cp
+    REQUIRE (st.live_bytes == base.live_bytes + 1000u);
+  }
+  SECTION ( "Vectors moved in are zero copy moves, not allocations" ) {
+    std::vector<std::byte> v1(1000u);
+    std::vector<std::byte> v2(2000u);
+    std::vector<std::byte> v3(500u);
+    auto cap { v1.capacity() + v2.capacity() + v3.capacity() };
+    chops::reset_shared_buffer_stats();
+    chops::mutable_shared_buffer msb(std::move(v1));
+    chops::const_shared_buffer csb(std::move(v2));
+    chops::local_const_shared_buffer lcsb(std::move(v3));
+    auto st { chops::shared_buffer_stats_snapshot() };
+    REQUIRE (st.allocations == 0u);
+    REQUIRE (st.size_histogram[6] == 0u);
+    REQUIRE (st.zero_copy_moves == 3u);
+    REQUIRE (st.bytes_moved == 3500u);
+    REQUIRE (st.live_buffers == base.live_buffers + 3u);
+    REQUIRE (st.live_bytes == base.live_bytes + cap);
+    msb.resize(5000u);
+    REQUIRE (chops::shared_buffer_stats_snapshot().reallocations == 1u);
+
+    std::pmr::monotonic_buffer_resource mres;
+    std::pmr::vector<std::byte> pv(1000u, &mres);
+    chops::reset_shared_buffer_stats();
+    chops::pmr::mutable_shared_buffer pmsb(std::move(pv));
+    REQUIRE (chops::shared_buffer_stats_snapshot().allocations == 0u);
+    REQUIRE (chops::shared_buffer_stats_snapshot().zero_copy_moves == 1u);
+
+    chops::local_mutable_shared_buffer lmsb(arr.data(), arr.size());
+    lmsb.resize(1000u);
+    chops::reset_shared_buffer_stats();
+    auto before { chops::shared_buffer_stats_snapshot() };
+    auto res { chops::to_shared(std::move(lmsb)) };
+    st = chops::shared_buffer_stats_snapshot();
+    REQUIRE (st.allocations == 0u);
+    REQUIRE (st.zero_copy_moves == 1u);
+    REQUIRE (st.bytes_moved == 1000u);
+    REQUIRE (st.live_bytes == before.live_bytes);
+
+    std::list<std::byte> lst(300u);
+    chops::reset_shared_buffer_stats();
+    chops::const_shared_buffer from_list(lst.begin(), lst.end()); // filled in, allocated
+    st = chops::shared_buffer_stats_snapshot();
+    REQUIRE (st.allocations == 1u);
+    REQUIRE (st.zero_copy_moves == 0u);
+  }
+  SECTION ( "Copy on write clone is a deep copy" ) {
+    chops::cow_mutable_shared_buffer a(arr.data(), arr.size());
+    chops::cow_mutable_shared_buffer b(a);
+    b.append(std::byte{0x05});
+    auto st { chops::shared_buffer_stats_snapshot() };
+    REQUIRE (st.deep_copies == 1u);
+    REQUIRE (st.bytes_copied == arr.size());
+  }
+  SECTION ( "Memory resource and local buffers" ) {
+    std::pmr::monotonic_buffer_resource res;
+    {
+      chops::pmr::mutable_shared_buffer pmsb(arr.data(), arr.size(), &res);
+      chops::local_const_shared_buffer lcsb(arr.data(), arr.size());
+      auto st { chops::shared_buffer_stats_snapshot() };
+      REQUIRE (st.allocations == 2u);
+      REQUIRE (st.live_buffers == base.live_buffers + 2u);
+    }
+    REQUIRE (chops::shared_buffer_stats_snapshot().live_buffers == base.live_buffers);
+  }
+  SECTION ( "Reset keeps the live counts" ) {
+    chops::const_shared_buffer csb(arr.data(), arr.size());
+    chops::reset_shared_buffer_stats();
+    auto st { chops::shared_buffer_stats_snapshot() };
+    REQUIRE (st.allocations == 0u);
+    REQUIRE (st.live_buffers == base.live_buffers + 1u);
+    REQUIRE (st.peak_live_bytes == st.live_bytes);
+  }
+}
+
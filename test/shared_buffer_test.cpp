@@ -18,11 +18,22 @@
 
 #include <cstddef> // std::byte
 #include <list>
+#include <vector>
+#include <string>
+#include <unordered_set>
 #include <string_view>
 #include <span>
 #include <array>
 #include <algorithm> // std::copy
 #include <bit> // std::bit_cast
+#include <memory> // std::allocator_arg
+#include <memory_resource>
+#include <optional>
+#include <utility> // std::as_const
+#include <cstdlib> // std::malloc, std::free
+#include <cstring> // std::memcpy
+#include <cstdint> // std::uint32_t
+#include <type_traits> // std::is_constructible_v, std::is_nothrow_constructible_v
 
 #include "buffer/shared_buffer.hpp"
 
@@ -35,6 +46,25 @@ constexpr test_data_type test_data { chops::make_byte_array( 40, 41, 42, 43, 44,
 char test_data_char[test_data_size] { 40, 41, 42, 43, 44, 60, 59, 58, 57, 56, 42, 42 };
 const char* test_data_char_ptr {test_data_char};
 
+// counts allocations passed through to the upstream resource
+class counting_resource : public std::pmr::memory_resource {
+public:
+  int allocs { 0 };
+  int deallocs { 0 };
+private:
+  void* do_allocate(std::size_t bytes, std::size_t align) override {
+    ++allocs;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+    ++deallocs;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
 template <typename SB>
 bool check_sb_against_test_data(SB sb) {
   REQUIRE (sb.size() == test_data_size);
@@ -133,6 +163,25 @@ void common_comparison_test() {
   REQUIRE_FALSE (sb2.empty());
   REQUIRE_FALSE (sb1 == sb2);
   REQUIRE (((sb1 < sb2) != 0)); // uses spaceship operator
+
+  auto ba3 { chops::make_byte_array(0x00, 0x22) };
+  auto ba4 { chops::make_byte_array(0x80, 0x01) };
+  SB sb3(ba3.cbegin(), ba3.cend());
+  SB sb4(ba4.cbegin(), ba4.cend());
+  REQUIRE (sb3 < sb2); // prefix orders first
+  REQUIRE (sb2 > sb3);
+  REQUIRE (sb2 < sb4); // bytes compare as unsigned
+  REQUIRE ((sb2 <=> SB(ba2.cbegin(), ba2.cend())) == std::strong_ordering::equal);
+
+  SB empty1(ba1.cbegin(), ba1.cbegin());
+  SB empty2(ba2.cbegin(), ba2.cbegin());
+  REQUIRE (empty1 == empty2);
+  REQUIRE (empty1 < sb3);
+  REQUIRE_FALSE (empty1 == sb3);
+
+  SB sb5(sb2); // shares storage
+  REQUIRE (sb5 == sb2);
+  REQUIRE ((sb5 <=> sb2) == std::strong_ordering::equal);
 }
 
 template <typename SB>
@@ -146,6 +195,46 @@ void byte_vector_move_test() {
   REQUIRE_FALSE (bv.size() == sb.size());
 }
  
+template <typename SB>
+void byte_range_construction_test() {
+
+  // non-contiguous ranges must be std::byte, pointer elements are never copied
+  static_assert(std::is_constructible_v<SB, std::list<std::byte>::iterator, std::list<std::byte>::iterator>);
+  static_assert(!std::is_constructible_v<SB, std::list<char>::iterator, std::list<char>::iterator>);
+  static_assert(!std::is_constructible_v<SB, std::vector<int>::iterator, std::vector<int>::iterator>);
+  static_assert(!std::is_constructible_v<SB, std::vector<const char*>>);
+  static_assert(!std::is_constructible_v<SB, const void* const*, std::size_t>);
+  if constexpr (std::is_same_v<SB, chops::const_shared_buffer>) {
+    static_assert(std::is_constructible_v<SB, std::allocator_arg_t, std::allocator<std::byte>,
+                                          const char*, std::size_t>);
+    static_assert(!std::is_constructible_v<SB, std::allocator_arg_t, std::allocator<std::byte>,
+                                           const std::string*, std::size_t>);
+  }
+
+  std::string str { "Hello" };
+  SB sb1(str.cbegin(), str.cend());
+  SB sb2(str);
+  SB sb3(std::vector<char>(str.cbegin(), str.cend()));
+  REQUIRE (sb1.size() == 5u);
+  REQUIRE (sb1 == sb2);
+  REQUIRE (sb1 == sb3);
+  REQUIRE (*(sb1.data()+4) == std::byte{'o'});
+
+  std::vector<std::uint16_t> wide { 0x0102u, 0x0304u };
+  SB sb4(wide); // element bytes, in native order
+  REQUIRE (sb4.size() == 4u);
+  REQUIRE (std::memcmp(sb4.data(), wide.data(), 4u) == 0);
+
+  SB empty(str.cbegin(), str.cbegin());
+  REQUIRE (empty.empty());
+}
+
+TEMPLATE_TEST_CASE ( "Shared buffer construction from byte like ranges and iterators",
+                     "[common]",
+                     chops::mutable_shared_buffer, chops::const_shared_buffer ) {
+  byte_range_construction_test<TestType>();
+}
+
 TEMPLATE_TEST_CASE ( "Generic pointer construction",
                      "[common]",
                      char, unsigned char, signed char, std::uint8_t ) {
@@ -288,6 +377,53 @@ TEST_CASE ( "Mutable shared buffer append",
   } 
 }
 
+TEST_CASE ( "Mutable shared buffer batch append",
+            "[mutable_shared_buffer] [append_all]" ) {
+
+  auto arr1 = chops::make_byte_array (0x01, 0x02, 0x03);
+  auto arr2 = chops::make_byte_array (0x04, 0x05);
+  std::vector<std::byte> bv { std::byte{0x06} };
+  chops::const_shared_buffer csb(arr1.cbegin(), arr1.cend());
+  auto expected = chops::make_byte_array (0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x01, 0x02, 0x03);
+
+  SECTION ( "Variadic pieces, grown once" ) {
+    chops::basic_mutable_shared_buffer<std::allocator<std::byte>, chops::exact_growth> sb;
+    sb.append_all(arr1, std::span<const std::byte>(arr2), bv, csb);
+    REQUIRE (sb.size() == expected.size());
+    REQUIRE (sb.capacity() == expected.size());
+    REQUIRE (std::equal(sb.data(), sb.data() + sb.size(), expected.cbegin()));
+  }
+  SECTION ( "Range of pieces" ) {
+    chops::mutable_shared_buffer sb(arr2.cbegin(), arr2.cend());
+    std::vector<chops::const_shared_buffer> pieces(3u, csb);
+    sb.append_all(pieces).append_all(std::list<std::span<const std::byte>> { arr2, bv });
+    REQUIRE (sb.size() == arr2.size() + 3u * arr1.size() + arr2.size() + bv.size());
+    REQUIRE (sb.data()[2] == std::byte{0x01});
+    REQUIRE (sb.data()[sb.size() - 1u] == std::byte{0x06});
+  }
+  SECTION ( "Repeated batches have amortized growth" ) {
+    chops::mutable_shared_buffer sb;
+    int reallocs { 0 };
+    chops::repeat(1000, [&] {
+      auto cap { sb.capacity() };
+      sb.append_all(arr1, arr2);
+      reallocs += (cap != sb.capacity()) ? 1 : 0;
+    } );
+    REQUIRE (sb.size() == 5000u);
+    REQUIRE (reallocs < 20);
+  }
+}
+
+TEST_CASE ( "Mutable shared buffer append from contiguous ranges",
+            "[mutable_shared_buffer] [append]" ) {
+
+  chops::mutable_shared_buffer sb;
+  std::string str { "ab" };
+  std::array<unsigned char, 2u> arr { 0x63u, 0x64u };
+  sb.append(str).append(arr).append(std::vector<std::byte> { std::byte{0x65} });
+  REQUIRE (sb == chops::mutable_shared_buffer(std::string_view("abcde")));
+}
+
 TEMPLATE_TEST_CASE ( "Generic pointer append",
                      "[mutable_shared_buffer] [pointer] [append]",
                      char, unsigned char, signed char, std::uint8_t ) {
@@ -310,6 +446,13 @@ TEST_CASE ( "Mutable shared buffer move into const shared buffer",
   auto arr1 = chops::make_byte_array (0xaa, 0xbb, 0xcc);
   auto arr2 = chops::make_byte_array (0x01, 0x02, 0x03, 0x04, 0x05);
 
+  // small or shared (copy on write) payloads are copied, and a moved vector gets a 
+  // shared block, so these may throw
+  static_assert(!std::is_nothrow_constructible_v<chops::const_shared_buffer, chops::mutable_shared_buffer&&>);
+  static_assert(!std::is_nothrow_constructible_v<chops::const_shared_buffer, 
+                                                 chops::cow_mutable_shared_buffer&&>);
+  static_assert(!std::is_nothrow_constructible_v<chops::const_shared_buffer, std::vector<std::byte>&&>);
+
   chops::mutable_shared_buffer msb(arr1.cbegin(), arr1.cend());
   chops::const_shared_buffer csb(std::move(msb));
   REQUIRE (csb == chops::const_shared_buffer(arr1.cbegin(), arr1.cend()));
@@ -320,6 +463,151 @@ TEST_CASE ( "Mutable shared buffer move into const shared buffer",
   REQUIRE_FALSE (msb == csb);
 }
 
+TEST_CASE ( "Const shared buffer storage sharing",
+            "[mutable_shared_buffer] [const_shared_buffer] [storage]" ) {
+
+  auto arr = chops::make_byte_array (0xaa, 0xbb, 0xcc, 0xdd);
+
+  SECTION ( "Moving a uniquely owned mutable shared buffer does not copy" ) {
+    chops::mutable_shared_buffer msb(chops::const_shared_buffer::inline_size + 1u);
+    const std::byte* ptr = msb.data();
+    chops::const_shared_buffer csb(std::move(msb));
+    REQUIRE (csb.data() == ptr);
+    REQUIRE (csb.size() == chops::const_shared_buffer::inline_size + 1u);
+    REQUIRE (msb.empty());
+  }
+  SECTION ( "Moving a small mutable shared buffer copies, capacity is kept for reuse" ) {
+    chops::mutable_shared_buffer msb(arr.cbegin(), arr.cend());
+    const std::byte* ptr = msb.data();
+    chops::const_shared_buffer csb(std::move(msb));
+    REQUIRE (csb.data() != ptr);
+    REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+    REQUIRE (msb.empty());
+    REQUIRE (msb.capacity() >= arr.size());
+    msb.append(arr.data(), arr.size());
+    REQUIRE (msb.data() == ptr);
+    REQUIRE (csb == msb);
+  }
+  SECTION ( "A moved from const shared buffer is empty" ) {
+    chops::const_shared_buffer csb(arr.data(), arr.size());
+    REQUIRE (csb.hash() != 0u);
+    chops::const_shared_buffer csb2(std::move(csb));
+    REQUIRE (csb2.size() == arr.size());
+    REQUIRE (csb2.hash() == chops::const_shared_buffer(arr.data(), arr.size()).hash());
+    REQUIRE (csb.empty());
+    REQUIRE (csb.data() == nullptr);
+    chops::const_shared_buffer empty(arr.data(), 0u);
+    REQUIRE (csb == empty);
+    REQUIRE ((csb <=> empty) == std::strong_ordering::equal);
+    REQUIRE (csb.hash() == empty.hash());
+    REQUIRE_FALSE (std::move(csb).try_reclaim());
+  }
+  SECTION ( "Moving a small vector copies" ) {
+    std::vector<std::byte> bv(arr.cbegin(), arr.cend());
+    const std::byte* ptr = bv.data();
+    chops::const_shared_buffer csb(std::move(bv));
+    REQUIRE (csb.data() != ptr);
+    REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+  }
+  SECTION ( "Moving a shared mutable shared buffer copies, later changes not visible" ) {
+    chops::mutable_shared_buffer msb(arr.cbegin(), arr.cend());
+    chops::mutable_shared_buffer msb2(msb);
+    chops::const_shared_buffer csb(std::move(msb));
+    REQUIRE (csb.data() != msb2.data());
+    REQUIRE (csb == msb2);
+    *(msb2.data()) = std::byte(0x01);
+    msb2.append(arr.data(), arr.size());
+    REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+  }
+  SECTION ( "Copies of a const shared buffer share the same bytes" ) {
+    chops::const_shared_buffer csb1(arr.data(), arr.size());
+    REQUIRE (csb1.data() != arr.data());
+    chops::const_shared_buffer csb2(csb1);
+    REQUIRE (csb2.data() == csb1.data());
+    REQUIRE (csb2.size() == csb1.size());
+  }
+}
+
+TEST_CASE ( "Const shared buffer reclaim into a mutable shared buffer",
+            "[mutable_shared_buffer] [const_shared_buffer] [reclaim]" ) {
+
+  constexpr auto sz { chops::const_shared_buffer::inline_size + 100u };
+
+  chops::mutable_shared_buffer msb(sz);
+  msb.reserve(2u * sz);
+  auto ptr { msb.data() };
+  chops::const_shared_buffer csb(std::move(msb));
+  REQUIRE (csb.data() == ptr);
+
+  SECTION ( "Unique owner is reclaimed without copying" ) {
+    auto res { std::move(csb).try_reclaim() };
+    REQUIRE (res);
+    REQUIRE (res->data() == ptr);
+    REQUIRE (res->size() == sz);
+    REQUIRE (res->capacity() >= 2u * sz);
+    REQUIRE (res->use_count() == 1);
+    REQUIRE (csb.empty());
+    res->clear();
+    res->append(std::byte{0x42}); // storage is reused
+    REQUIRE (res->data() == ptr);
+  }
+  SECTION ( "Shared storage is not reclaimed" ) {
+    auto cp { csb };
+    REQUIRE_FALSE (std::move(csb).try_reclaim());
+    REQUIRE (csb.size() == sz); // unchanged
+    {
+      auto sl { cp.slice(1u) };
+      REQUIRE_FALSE (std::move(cp).try_reclaim());
+      REQUIRE_FALSE (std::move(sl).try_reclaim());
+    }
+    auto cp2 { std::move(cp) };
+    REQUIRE_FALSE (std::move(csb).try_reclaim()); // cp2 still shares
+  }
+  SECTION ( "A moved in vector is reclaimed" ) {
+    std::vector<std::byte> bv(sz);
+    auto vptr { bv.data() };
+    chops::const_shared_buffer vcsb(std::move(bv));
+    auto res { std::move(vcsb).try_reclaim() };
+    REQUIRE (res);
+    REQUIRE (res->data() == vptr);
+  }
+  SECTION ( "Copied bytes are not reclaimed" ) {
+    chops::const_shared_buffer small(ptr, 10u);
+    REQUIRE_FALSE (std::move(small).try_reclaim());
+    chops::const_shared_buffer big(ptr, sz);
+    REQUIRE_FALSE (std::move(big).try_reclaim());
+  }
+}
+
+TEST_CASE ( "Const shared buffer slices",
+            "[const_shared_buffer] [slice]" ) {
+
+  auto arr = chops::make_byte_array (0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08);
+  auto arr2 = chops::make_byte_array (0x03, 0x04, 0x05);
+
+  std::optional<chops::const_shared_buffer> csb { std::in_place, arr.data(), arr.size() };
+  auto sl { csb->slice(2u, 3u) };
+  REQUIRE (sl.size() == 3u);
+  REQUIRE (sl.data() == csb->data() + 2);
+  REQUIRE (sl == chops::const_shared_buffer(arr2.cbegin(), arr2.cend()));
+
+  auto tail { csb->slice(5u) };
+  REQUIRE (tail.size() == 3u);
+  REQUIRE (std::to_integer<int>(*tail.data()) == 0x06);
+
+  auto empty_sl { csb->slice(arr.size()) };
+  REQUIRE (empty_sl.empty());
+
+  auto sl2 { sl.slice(1u, 1u) };
+  REQUIRE (sl2.size() == 1u);
+  REQUIRE (std::to_integer<int>(*sl2.data()) == 0x04);
+
+  csb.reset(); // slices keep the bytes alive
+  REQUIRE (std::to_integer<int>(*sl.data()) == 0x03);
+  REQUIRE (sl == chops::const_shared_buffer(arr2.cbegin(), arr2.cend()));
+  REQUIRE (std::to_integer<int>(*sl2.data()) == 0x04);
+}
+
 TEMPLATE_TEST_CASE ( "Move a vector of bytes into a shared buffer",
                      "[common] [move_byte_vec]",
                      chops::mutable_shared_buffer, chops::const_shared_buffer ) {
@@ -328,6 +616,79 @@ TEMPLATE_TEST_CASE ( "Move a vector of bytes into a shared buffer",
 
 }
 
+TEST_CASE ( "Const shared buffer adopting external memory with a deleter",
+            "[const_shared_buffer] [deleter]" ) {
+
+  auto arr = chops::make_byte_array (0x01, 0x02, 0x03, 0x04);
+  int deletes = 0;
+
+  SECTION ( "Deleter called once when the last reference goes away" ) {
+    auto ext = new std::byte[arr.size()];
+    std::copy(arr.cbegin(), arr.cend(), ext);
+    {
+      chops::const_shared_buffer csb(ext, arr.size(), [&deletes] (std::byte* p) { ++deletes; delete[] p; } );
+      REQUIRE (csb.data() == ext);
+      REQUIRE (csb.size() == arr.size());
+      auto sl { csb.slice(1u) };
+      chops::const_shared_buffer csb2(csb);
+      REQUIRE (deletes == 0);
+      REQUIRE (sl == chops::const_shared_buffer(arr.data()+1, arr.size()-1u));
+    }
+    REQUIRE (deletes == 1);
+  }
+  SECTION ( "Void pointer from a C library, size in bytes" ) {
+    void* ext = std::malloc(arr.size());
+    std::memcpy(ext, arr.data(), arr.size());
+    chops::const_shared_buffer csb(ext, arr.size(), [] (void* p) { std::free(p); } );
+    REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+  }
+  SECTION ( "Non-byte element type, size in elements" ) {
+    static const std::uint32_t vals[] { 1u, 2u, 3u };
+    chops::const_shared_buffer csb(vals, 3u, [&deletes] (const std::uint32_t*) { ++deletes; } );
+    REQUIRE (csb.size() == sizeof(vals));
+    REQUIRE (static_cast<const void*>(csb.data()) == static_cast<const void*>(vals));
+  }
+  SECTION ( "Reference count from a memory resource" ) {
+    counting_resource res;
+    {
+      chops::const_shared_buffer csb(std::allocator_arg, &res, arr.data(), arr.size(),
+                                     [&deletes] (const std::byte*) { ++deletes; } );
+      REQUIRE (csb.data() == arr.data());
+      REQUIRE (res.allocs == 1);
+    }
+    REQUIRE (res.deallocs == 1);
+    REQUIRE (deletes == 1);
+  }
+}
+
+TEST_CASE ( "Const shared buffer hashing",
+            "[const_shared_buffer] [hash]" ) {
+
+  auto arr1 = chops::make_byte_array (0x01, 0x02, 0x03, 0x04, 0x05);
+  auto arr2 = chops::make_byte_array (0x01, 0x02, 0x03, 0x04, 0x06);
+
+  chops::const_shared_buffer csb1(arr1.cbegin(), arr1.cend());
+  chops::const_shared_buffer csb2(arr1.cbegin(), arr1.cend());
+  chops::const_shared_buffer csb3(arr2.cbegin(), arr2.cend());
+  std::hash<chops::const_shared_buffer> hasher;
+
+  REQUIRE (hasher(csb1) == hasher(csb2));
+  REQUIRE (hasher(csb1) == csb1.hash()); // cached value
+  REQUIRE_FALSE (hasher(csb1) == hasher(csb3));
+  REQUIRE_FALSE (csb1 == csb3); // both hashes cached
+  REQUIRE (csb1 == csb2);
+  chops::const_shared_buffer csb4(csb1);
+  REQUIRE (csb4.hash() == csb1.hash());
+  REQUIRE (csb1.slice(1u).hash() == chops::const_shared_buffer(arr1.data()+1, arr1.size()-1u).hash());
+
+  std::unordered_set<chops::const_shared_buffer> keys;
+  keys.insert(csb1);
+  keys.insert(csb2);
+  keys.insert(csb3);
+  REQUIRE (keys.size() == 2u);
+  REQUIRE (keys.contains(chops::const_shared_buffer(arr2.cbegin(), arr2.cend())));
+}
+
 TEST_CASE ( "Use get_byte_vec for external modification of buffer",
             "[mutable_shared_buffer] [get_byte_vec]" ) {
 
@@ -346,3 +707,305 @@ TEST_CASE ( "Use get_byte_vec for external modification of buffer",
   REQUIRE_FALSE (chops::compare_byte_arrays(arr, arr3));
 }
 
+
+TEST_CASE ( "Shared buffers using a memory resource",
+            "[mutable_shared_buffer] [const_shared_buffer] [pmr]" ) {
+
+  auto arr = chops::make_byte_array (0xaa, 0xbb, 0xcc, 0xdd);
+  counting_resource res;
+
+  SECTION ( "Mutable shared buffer, reference count and bytes from the resource" ) {
+    {
+      chops::pmr::mutable_shared_buffer msb(arr.data(), arr.size(), &res);
+      REQUIRE (res.allocs == 2);
+      REQUIRE (msb.get_allocator().resource() == &res);
+      msb.append(arr.data(), arr.size());
+      REQUIRE (msb.size() == 2u * arr.size());
+      chops::pmr::mutable_shared_buffer msb2(msb);
+      REQUIRE (msb2 == msb);
+    }
+    REQUIRE (res.allocs > 2);
+    REQUIRE (res.allocs == res.deallocs);
+  }
+  SECTION ( "Const shared buffer, one allocation from the resource" ) {
+    {
+      chops::const_shared_buffer csb(std::allocator_arg, &res, arr.data(), arr.size());
+      REQUIRE (res.allocs == 1);
+      REQUIRE (csb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+      chops::const_shared_buffer csb2(csb);
+      REQUIRE (res.allocs == 1);
+    }
+    REQUIRE (res.deallocs == 1);
+  }
+  SECTION ( "Move pmr mutable shared buffer into const shared buffer" ) {
+    chops::pmr::mutable_shared_buffer msb(chops::const_shared_buffer::inline_size + 1u, &res);
+    const std::byte* ptr = msb.data();
+    chops::const_shared_buffer csb(std::move(msb));
+    REQUIRE (csb.data() == ptr);
+    REQUIRE (msb.empty());
+    REQUIRE (msb.get_allocator().resource() == &res);
+    REQUIRE (csb.size() == chops::const_shared_buffer::inline_size + 1u);
+  }
+}
+
+TEST_CASE ( "Mutable shared buffer empty state does not allocate",
+            "[mutable_shared_buffer] [const_shared_buffer] [empty]" ) {
+
+  auto arr = chops::make_byte_array (0x01, 0x02, 0x03, 0x04);
+  counting_resource res;
+
+  chops::pmr::mutable_shared_buffer msb(&res);
+  REQUIRE (res.allocs == 0);
+  REQUIRE (msb.empty());
+  REQUIRE (msb.size() == 0u);
+  REQUIRE (msb.capacity() == 0u);
+  REQUIRE (msb.data() == nullptr);
+  REQUIRE (msb.use_count() == 0);
+  REQUIRE (msb == chops::pmr::mutable_shared_buffer(&res));
+  msb.clear();
+  msb.shrink_to_fit();
+  REQUIRE (res.allocs == 0);
+
+  SECTION ( "Handoff to a const shared buffer leaves an empty buffer without allocating" ) {
+    msb.resize(chops::const_shared_buffer::inline_size + 1u);
+    auto allocs { res.allocs };
+    chops::const_shared_buffer csb(std::move(msb));
+    REQUIRE (res.allocs == allocs);
+    REQUIRE (msb.empty());
+    REQUIRE (msb.get_allocator().resource() == &res);
+    msb.append(arr.data(), arr.size()); // storage created on first use, from the resource
+    REQUIRE (res.allocs == allocs + 2);
+    REQUIRE (msb == chops::const_shared_buffer(arr.cbegin(), arr.cend()));
+  }
+  SECTION ( "Copies of an empty buffer without storage are independent" ) {
+    chops::pmr::mutable_shared_buffer msb2(msb);
+    msb.append(arr.data(), arr.size());
+    REQUIRE (msb.size() == arr.size());
+    REQUIRE (msb2.empty());
+    msb2 = msb; // assignment works with polymorphic_allocator
+    REQUIRE (msb2.data() == msb.data());
+  }
+  SECTION ( "Moved from mutable shared buffer is empty and usable" ) {
+    msb.append(arr.data(), arr.size());
+    auto msb2 { std::move(msb) };
+    REQUIRE (msb.empty());
+    REQUIRE (msb2.size() == arr.size());
+    msb += std::byte{0x05};
+    REQUIRE (msb.size() == 1u);
+  }
+  SECTION ( "get_byte_vec creates the storage" ) {
+    msb.get_byte_vec().push_back(std::byte{0x01});
+    REQUIRE (msb.size() == 1u);
+    REQUIRE (msb.use_count() == 1);
+  }
+}
+
+TEST_CASE ( "Copy on write mutable shared buffer",
+            "[mutable_shared_buffer] [copy_on_write]" ) {
+
+  auto arr = chops::make_byte_array (0x01, 0x02, 0x03, 0x04, 0x05);
+
+  chops::cow_mutable_shared_buffer sb1(arr.cbegin(), arr.cend());
+  chops::cow_mutable_shared_buffer sb2(sb1);
+  const auto& csb1 { sb1 };
+  const auto& csb2 { sb2 };
+  REQUIRE (sb1.use_count() == 2);
+  REQUIRE (csb1.data() == csb2.data()); // shared until modified
+
+  SECTION ( "Writing through data clones the shared buffer" ) {
+    sb2.data()[0] = std::byte{0x7f};
+    REQUIRE (sb1.use_count() == 1);
+    REQUIRE (sb2.use_count() == 1);
+    REQUIRE_FALSE (csb1.data() == csb2.data());
+    REQUIRE (sb1 == chops::cow_mutable_shared_buffer(arr.cbegin(), arr.cend()));
+    REQUIRE (sb2.data()[0] == std::byte{0x7f});
+    auto ptr { sb2.data() };
+    sb2.data()[1] = std::byte{0x7f}; // uniquely owned, no clone
+    REQUIRE (sb2.data() == ptr);
+  }
+  SECTION ( "Append, resize and get_byte_vec clone the shared buffer" ) {
+    sb2.append(std::byte{0x06});
+    REQUIRE (sb1.size() == arr.size());
+    REQUIRE (sb2.size() == arr.size() + 1u);
+    chops::cow_mutable_shared_buffer sb3(sb1);
+    sb3.resize(2u);
+    REQUIRE (sb1.size() == arr.size());
+    chops::cow_mutable_shared_buffer sb4(sb1);
+    sb4.get_byte_vec().push_back(std::byte{0x08});
+    REQUIRE (sb1.size() == arr.size());
+    REQUIRE (sb4.size() == arr.size() + 1u);
+  }
+  SECTION ( "Clear releases a shared buffer" ) {
+    sb2.clear();
+    REQUIRE (sb2.empty());
+    REQUIRE (sb1.size() == arr.size());
+    REQUIRE (sb1.use_count() == 1);
+  }
+  SECTION ( "Move into a const shared buffer does not clone" ) {
+    chops::cow_mutable_shared_buffer big(chops::const_shared_buffer::inline_size + 10u);
+    chops::cow_mutable_shared_buffer cp(big);
+    auto ptr { std::as_const(big).data() };
+    chops::const_shared_buffer csb(std::move(cp));
+    REQUIRE (big.use_count() == 1);
+    REQUIRE_FALSE (csb.data() == ptr); // shared, so the bytes are copied
+    REQUIRE (csb == big);
+    chops::const_shared_buffer moved_csb(std::move(big));
+    REQUIRE (moved_csb.data() == ptr); // uniquely owned, no copy
+  }
+}
+
+TEST_CASE ( "Mutable shared buffer uninitialized resize and append",
+            "[mutable_shared_buffer] [uninitialized]" ) {
+
+  using uninit_buffer = chops::basic_mutable_shared_buffer<chops::default_init_allocator<std::byte>>;
+
+  constexpr int N = 20;
+  auto arr = chops::make_byte_array (0xaa, 0xbb, 0xcc);
+
+  uninit_buffer sb(N);
+  REQUIRE (sb.size() == N);
+  chops::repeat(N, [&sb] (int i) { REQUIRE (std::to_integer<int>(*(sb.data() + i)) == 0 ); } );
+
+  auto sp = sb.resize_uninitialized(2 * N);
+  REQUIRE (sp.size() == 2 * N);
+  REQUIRE (sp.data() == sb.data());
+  std::fill(sp.begin(), sp.end(), std::byte(0xff));
+
+  SECTION ( "Resize still zero fills" ) {
+    sb.clear();
+    sb.resize(N);
+    chops::repeat(N, [&sb] (int i) { REQUIRE (std::to_integer<int>(*(sb.data() + i)) == 0 ); } );
+  }
+  SECTION ( "Append uninitialized returns the new bytes" ) {
+    auto sp2 = sb.append_uninitialized(arr.size());
+    REQUIRE (sb.size() == 2 * N + arr.size());
+    REQUIRE (sp2.size() == arr.size());
+    REQUIRE (sp2.data() == sb.data() + 2 * N);
+    std::copy(arr.cbegin(), arr.cend(), sp2.begin());
+    REQUIRE (std::to_integer<int>(*(sb.data() + 2 * N + 2)) == 0xcc);
+    chops::const_shared_buffer csb(std::move(sb));
+    REQUIRE (csb.size() == 2 * N + arr.size());
+  }
+  SECTION ( "Default allocator" ) {
+    chops::mutable_shared_buffer msb;
+    auto sp3 = msb.append_uninitialized(arr.size());
+    std::copy(arr.cbegin(), arr.cend(), sp3.begin());
+    REQUIRE (msb == chops::mutable_shared_buffer(arr.cbegin(), arr.cend()));
+    REQUIRE (msb.resize_uninitialized(1u).size() == 1u);
+  }
+}
+
+TEST_CASE ( "Mutable shared buffer capacity and growth policies",
+            "[mutable_shared_buffer] [capacity]" ) {
+
+  auto arr = chops::make_byte_array (0xaa, 0xbb, 0xcc);
+
+  SECTION ( "Reserve, capacity, and shrink to fit" ) {
+    chops::mutable_shared_buffer sb;
+    sb.reserve(100u);
+    REQUIRE (sb.capacity() >= 100u);
+    const std::byte* ptr = sb.data();
+    chops::repeat(100, [&sb] { sb.append(std::byte(0x42)); } );
+    REQUIRE (sb.size() == 100u);
+    REQUIRE (sb.data() == ptr);
+    sb.resize(10u);
+    sb.shrink_to_fit();
+    REQUIRE (sb.capacity() >= 10u);
+    REQUIRE (sb.size() == 10u);
+  }
+  SECTION ( "Exact growth" ) {
+    chops::basic_mutable_shared_buffer<std::allocator<std::byte>, chops::exact_growth> sb;
+    chops::repeat(5, [&sb, &arr] {
+      sb.append(arr.data(), arr.size());
+      REQUIRE (sb.capacity() == sb.size());
+    } );
+    REQUIRE (sb.size() == 5u * arr.size());
+    chops::const_shared_buffer csb(std::move(sb));
+    REQUIRE (csb.size() == 5u * arr.size());
+  }
+  SECTION ( "Geometric growth" ) {
+    chops::basic_mutable_shared_buffer<std::allocator<std::byte>, chops::geometric_growth<3u, 2u>> sb(10u);
+    auto cap { sb.capacity() };
+    sb.append(std::byte(0x42));
+    REQUIRE (sb.capacity() >= cap + cap / 2u);
+    REQUIRE (sb.size() == 11u);
+  }
+  SECTION ( "Page growth" ) {
+    chops::basic_mutable_shared_buffer<std::allocator<std::byte>, chops::page_growth<4096u>> sb;
+    sb.append(arr.data(), arr.size());
+    REQUIRE (sb.capacity() >= 4096u);
+    sb.resize_uninitialized(5000u);
+    REQUIRE (sb.capacity() >= 8192u);
+  }
+  SECTION ( "Growth policy values" ) {
+    REQUIRE (chops::geometric_growth<>::next_capacity(10u, 11u) == 20u);
+    REQUIRE (chops::geometric_growth<3u, 2u>::next_capacity(10u, 11u) == 15u);
+    REQUIRE (chops::geometric_growth<3u, 2u>::next_capacity(10u, 40u) == 40u);
+    REQUIRE (chops::page_growth<4096u>::next_capacity(0u, 1u) == 4096u);
+    REQUIRE (chops::page_growth<4096u>::next_capacity(4096u, 4097u) == 8192u);
+    REQUIRE (chops::exact_growth::next_capacity(100u, 101u) == 101u);
+  }
+}
+
+TEST_CASE ( "Mutable shared buffer read offset",
+            "[mutable_shared_buffer] [consume]" ) {
+
+  auto arr { chops::make_byte_array(0x01, 0x02, 0x03, 0x04, 0x05, 0x06) };
+  chops::mutable_shared_buffer sb(arr.cbegin(), arr.cend());
+  auto ptr { sb.data() };
+
+  REQUIRE (sb.consumed() == 0u);
+  REQUIRE (sb.readable().size() == 6u);
+  sb.consume(2u);
+  REQUIRE (sb.consumed() == 2u);
+  REQUIRE (sb.size() == 6u); // consumed bytes stay until compacted
+  REQUIRE (sb.readable().data() == ptr + 2);
+  REQUIRE (sb.readable().size() == 4u);
+  REQUIRE (sb.readable()[0] == std::byte{0x03});
+
+  SECTION ( "Compact moves the readable bytes to the front" ) {
+    sb.compact();
+    REQUIRE (sb.consumed() == 0u);
+    REQUIRE (sb.size() == 4u);
+    REQUIRE (sb.data() == ptr);
+    REQUIRE (*sb.data() == std::byte{0x03});
+    sb.compact(); // nothing consumed
+    REQUIRE (sb.size() == 4u);
+  }
+  SECTION ( "Consuming everything clears the buffer, keeping the capacity" ) {
+    sb.append(std::byte{0x07});
+    auto cap { sb.capacity() };
+    ptr = sb.data();
+    sb.consume(5u);
+    REQUIRE (sb.empty());
+    REQUIRE (sb.consumed() == 0u);
+    REQUIRE (sb.capacity() == cap);
+    REQUIRE (sb.readable().empty());
+    sb.append(std::byte{0x08});
+    REQUIRE (sb.data() == ptr);
+    REQUIRE (sb.readable().size() == 1u);
+  }
+  SECTION ( "Read offset of copy on write copies, and reset after a move" ) {
+    chops::cow_mutable_shared_buffer cw(arr.cbegin(), arr.cend());
+    cw.consume(2u);
+    chops::cow_mutable_shared_buffer cp(cw); // shares the bytes, with its own read offset
+    cp.consume(1u);
+    REQUIRE (cp.consumed() == 3u);
+    REQUIRE (cw.consumed() == 2u);
+    cp.compact(); // clones first, cw is not affected
+    REQUIRE (cp.consumed() == 0u);
+    REQUIRE (*cp.readable().data() == std::byte{0x04});
+    REQUIRE (cw.readable().size() == 4u);
+    REQUIRE (*cw.readable().data() == std::byte{0x03});
+    chops::cow_mutable_shared_buffer cp2(cw);
+    cp2.consume(4u); // releases the shared bytes
+    REQUIRE (cp2.empty());
+    REQUIRE (cw.readable().size() == 4u);
+
+    chops::const_shared_buffer csb(std::move(sb));
+    REQUIRE (csb.size() == 6u);
+    sb.append(std::byte{0x09});
+    REQUIRE (sb.consumed() == 0u);
+    REQUIRE (sb.readable().size() == 1u);
+  }
+}
@@ -0,0 +1,140 @@
+/** @file
+ *
+ * @brief Test scenarios for @c shared_memory_arena.
+ *
+ * Separate arena objects for the same shared memory object attach as separate
+ * processes, and a child process is forked to check the recovery of references
+ * held by a process that exits without releasing them.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <cstring> // std::memcpy
+#include <string>
+#include <optional>
+#include <stdexcept> // std::length_error
+#include <type_traits> // std::is_trivially_copyable_v
+
+#include <sys/wait.h> // waitpid
+#include <unistd.h> // fork, _exit, getpid
+
+#include "buffer/shared_memory_arena.hpp"
+#include "buffer/shared_buffer.hpp"
+
+#include "utility/byte_array.hpp"
+
+namespace {
+
+std::string arena_name() {
+  return "/chops_arena_test_" + std::to_string(::getpid());
+}
+
+}
+
+TEST_CASE ( "Shared memory arena buffers passed between processes",
+            "[shared_memory_arena]" ) {
+
+  static_assert(std::is_trivially_copyable_v<chops::shared_memory_handle>);
+
+  auto name { arena_name() };
+  chops::shared_memory_arena::remove(name);
+  auto producer { chops::shared_memory_arena::create(name, 4u, 100u) };
+  auto consumer { chops::shared_memory_arena::open(name) };
+  chops::shared_memory_arena::remove(name); // attached arenas are not affected
+  REQUIRE (producer.num_slots() == 4u);
+  REQUIRE (producer.slot_size() == 128u);
+  REQUIRE (consumer.slot_size() == 128u);
+  REQUIRE (consumer.free_slots() == 4u);
+
+  auto arr { chops::make_byte_array(0x01, 0x02, 0x03, 0x04, 0x05) };
+
+  SECTION ( "Copy, send a handle, and view without copying" ) {
+    std::optional<chops::const_shared_buffer> buf { producer.copy(arr) };
+    auto hdl { producer.handle(*buf) };
+    REQUIRE (hdl.length == 5u);
+    auto view { consumer.view(hdl) };
+    REQUIRE (view);
+    REQUIRE (*view == *buf);
+    REQUIRE (producer.free_slots() == 3u);
+
+    auto view2 { consumer.view(hdl) }; // held locally
+    REQUIRE (view2);
+    buf.reset();
+    REQUIRE (producer.free_slots() == 3u); // still held by the consumer
+    view.reset();
+    view2.reset();
+    REQUIRE (producer.free_slots() == 4u);
+    REQUIRE_FALSE (consumer.view(hdl)); // stale
+    auto reused { producer.copy(arr) };
+    REQUIRE_FALSE (consumer.view(hdl)); // stale, new generation
+  }
+  SECTION ( "Write into a slot, publish, and view a slice" ) {
+    auto slot { producer.allocate() };
+    REQUIRE (slot.capacity() == 128u);
+    std::memcpy(slot.data(), arr.data(), arr.size());
+    auto buf { std::move(slot).publish(arr.size()) };
+    auto view { consumer.view(producer.handle(buf.slice(2u, 2u))) };
+    REQUIRE (view);
+    REQUIRE (view->size() == 2u);
+    REQUIRE (*view->data() == std::byte{0x03});
+    REQUIRE_THROWS_AS (producer.handle(chops::const_shared_buffer(arr.data(), arr.size())),
+                       std::invalid_argument);
+    REQUIRE_FALSE (consumer.view(chops::shared_memory_handle { 120u, 10u, 1u })); // past the slot
+  }
+  SECTION ( "Exhausted arena and buffers larger than a slot" ) {
+    auto a { producer.copy(arr) };
+    auto b { producer.copy(arr) };
+    auto c { consumer.copy(arr) };
+    auto d { consumer.copy(arr) };
+    REQUIRE_FALSE (producer.try_allocate());
+    REQUIRE_THROWS_AS (producer.allocate(), std::bad_alloc);
+    REQUIRE (producer.free_slots() == 0u);
+    std::byte big[200] { };
+    REQUIRE_THROWS_AS (consumer.copy(big), std::length_error);
+  }
+  SECTION ( "Buffers outlive the arena object" ) {
+    std::optional<chops::shared_memory_arena> tmp { chops::shared_memory_arena::from_fd(producer.fd()) };
+    auto buf { tmp->copy(arr) };
+    auto hdl { tmp->handle(buf) };
+    tmp.reset();
+    REQUIRE (*buf.data() == std::byte{0x01});
+    auto view { consumer.view(hdl) };
+    REQUIRE (view);
+  }
+}
+
+TEST_CASE ( "Shared memory arena recovery from a crashed process",
+            "[shared_memory_arena] [reclaim]" ) {
+
+  auto producer { chops::shared_memory_arena::create_anonymous(2u, 64u) };
+  auto arr { chops::make_byte_array(0x0A, 0x0B) };
+  std::optional<chops::const_shared_buffer> buf { producer.copy(arr) };
+  auto hdl { producer.handle(*buf) };
+
+  auto pid { ::fork() };
+  REQUIRE (pid >= 0);
+  if (pid == 0) {
+    auto consumer { chops::shared_memory_arena::from_fd(producer.fd()) };
+    auto view { consumer.view(hdl) };
+    ::_exit(view ? 0 : 1); // exits without releasing anything
+  }
+  int status { 0 };
+  REQUIRE (::waitpid(pid, &status, 0) == pid);
+  REQUIRE (WIFEXITED(status));
+  REQUIRE (WEXITSTATUS(status) == 0);
+
+  buf.reset();
+  REQUIRE (producer.free_slots() == 1u); // still held by the exited process
+  REQUIRE (producer.reclaim() == 1u);
+  REQUIRE (producer.free_slots() == 2u);
+  REQUIRE (producer.reclaim() == 0u);
+}
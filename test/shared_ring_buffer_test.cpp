@@ -0,0 +1,213 @@
+/** @file
+ *
+ * @brief Test scenarios for @c shared_ring_buffer and @c mpmc_shared_ring_buffer classes.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <cstdint> // std::uint32_t
+#include <cstring> // std::memcpy
+#include <memory> // std::unique_ptr
+#include <optional>
+#include <span>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <list>
+#include <iterator> // std::next
+
+#include "buffer/shared_ring_buffer.hpp"
+#include "buffer/shared_buffer.hpp"
+
+namespace {
+
+std::span<const std::byte> bytes_of(const std::uint32_t& val) {
+  return std::as_bytes(std::span<const std::uint32_t, 1u>(&val, 1u));
+}
+
+std::uint32_t value_of(const chops::const_shared_buffer& buf) {
+  std::uint32_t val;
+  std::memcpy(&val, buf.data(), sizeof(val));
+  return val;
+}
+
+}
+
+TEST_CASE ( "Single producer single consumer ring buffer",
+            "[shared_ring_buffer]" ) {
+
+  constexpr std::size_t rec_sz { chops::shared_ring_buffer::header_size + 16u };
+
+  SECTION ( "Reserve, commit, and pop" ) {
+    chops::shared_ring_buffer ring(4u * rec_sz);
+    REQUIRE (ring.capacity() == 4u * rec_sz);
+    REQUIRE_FALSE (ring.try_pop());
+
+    auto sp { ring.reserve(10u) };
+    REQUIRE (sp.size() == 10u);
+    sp[0] = std::byte{0x42};
+    REQUIRE_FALSE (ring.try_pop()); // not committed
+    ring.commit(3u);
+    auto msg { ring.try_pop() };
+    REQUIRE (msg);
+    REQUIRE (msg->size() == 3u);
+    REQUIRE (msg->data() == sp.data()); // no copy
+    REQUIRE (msg->data()[0] == std::byte{0x42});
+    REQUIRE_FALSE (ring.try_pop());
+  }
+  SECTION ( "Space is reused only after messages are released" ) {
+    chops::shared_ring_buffer ring(4u * rec_sz);
+    for (std::uint32_t i = 0u; i < 4u; ++i) {
+      REQUIRE (ring.try_push(bytes_of(i)));
+    }
+    REQUIRE_FALSE (ring.try_push(bytes_of(4u))); // full
+    std::list<chops::const_shared_buffer> msgs;
+    while (auto msg = ring.try_pop()) {
+      msgs.push_back(*msg);
+    }
+    REQUIRE (msgs.size() == 4u);
+    REQUIRE_FALSE (ring.try_push(bytes_of(4u))); // popped but not released
+    std::optional<chops::const_shared_buffer> cp { msgs.front() };
+    msgs.pop_front();
+    REQUIRE_FALSE (ring.try_push(bytes_of(4u))); // a copy is still held
+    cp.reset();
+    REQUIRE (ring.try_push(bytes_of(4u)));
+    REQUIRE_FALSE (ring.try_push(bytes_of(5u)));
+    REQUIRE (value_of(*std::next(msgs.begin())) == 2u);
+    msgs.clear();
+    REQUIRE (ring.try_push(bytes_of(5u)));
+    REQUIRE (value_of(*ring.try_pop()) == 4u);
+    REQUIRE (value_of(*ring.try_pop()) == 5u);
+  }
+  SECTION ( "Messages that do not fit at the end wrap around" ) {
+    chops::shared_ring_buffer ring(3u * rec_sz);
+    REQUIRE (ring.try_push(bytes_of(1u)));
+    REQUIRE (ring.try_push(bytes_of(2u)));
+    ring.try_pop();
+    ring.try_pop(); // released right away
+    auto sp { ring.reserve(2u * 16u + 16u) }; // does not fit in the last record space
+    REQUIRE (sp.size() == 48u);
+    ring.commit(48u);
+    auto msg { ring.try_pop() };
+    REQUIRE (msg);
+    REQUIRE (msg->size() == 48u);
+    REQUIRE (msg->data() == sp.data());
+    REQUIRE (ring.reserve(4u * rec_sz).empty()); // larger than the ring
+  }
+  SECTION ( "Messages outlive the ring buffer" ) {
+    std::optional<chops::const_shared_buffer> msg;
+    {
+      chops::shared_ring_buffer ring(4u * rec_sz);
+      ring.try_push(bytes_of(42u));
+      msg.emplace(*ring.try_pop());
+    }
+    REQUIRE (value_of(*msg) == 42u);
+  }
+  SECTION ( "Threaded producer and consumer" ) {
+    chops::shared_ring_buffer ring(64u * rec_sz);
+    constexpr std::uint32_t num { 100000u };
+    std::thread prod([&ring] {
+      for (std::uint32_t i = 0u; i < num; ++i) {
+        auto sz { 4u + (i % 50u) };
+        std::span<std::byte> sp;
+        while ((sp = ring.reserve(sz)).empty()) {
+          std::this_thread::yield();
+        }
+        std::memcpy(sp.data(), &i, sizeof(i));
+        ring.commit(sz);
+      }
+    } );
+    std::uint32_t expected { 0u };
+    std::vector<chops::const_shared_buffer> held; // released in batches
+    while (expected < num) {
+      if (auto msg = ring.try_pop()) {
+        REQUIRE (value_of(*msg) == expected);
+        REQUIRE (msg->size() == 4u + (expected % 50u));
+        ++expected;
+        held.push_back(*msg);
+        if (held.size() == 8u) {
+          held.clear();
+        }
+      }
+      else {
+        held.clear();
+        std::this_thread::yield();
+      }
+    }
+    prod.join();
+    REQUIRE (expected == num);
+  }
+}
+
+TEST_CASE ( "Multiple producer multiple consumer ring buffer",
+            "[mpmc_shared_ring_buffer]" ) {
+
+  SECTION ( "Reserve, commit, and pop" ) {
+    chops::mpmc_shared_ring_buffer ring(100u, 2u);
+    REQUIRE (ring.slot_size() == 100u);
+    REQUIRE (ring.slot_count() == 2u);
+    auto r1 { ring.try_reserve() };
+    auto r2 { ring.try_reserve() };
+    REQUIRE (r1);
+    REQUIRE (r2);
+    REQUIRE (r1->bytes.size() == 100u);
+    REQUIRE_FALSE (ring.try_reserve());
+    REQUIRE_FALSE (ring.try_pop());
+    r1->bytes[0] = std::byte{0x01};
+    ring.commit(*r1, 1u);
+    ring.commit(*r2, 50u);
+    auto m1 { ring.try_pop() };
+    REQUIRE (m1);
+    REQUIRE (m1->size() == 1u);
+    REQUIRE (m1->data() == r1->bytes.data());
+    REQUIRE (ring.try_pop()->size() == 50u); // released right away
+    REQUIRE_FALSE (ring.try_reserve()); // slots are used in order, the first is still held
+    m1.reset();
+    REQUIRE (ring.try_reserve());
+    REQUIRE (ring.try_reserve());
+    REQUIRE_FALSE (ring.try_reserve());
+  }
+  SECTION ( "Threaded producers and consumers" ) {
+    chops::mpmc_shared_ring_buffer ring(sizeof(std::uint32_t), 16u);
+    constexpr std::uint32_t per_thread { 20000u };
+    constexpr int num_threads { 3 };
+    std::atomic<std::uint64_t> sum { 0u };
+    std::atomic<std::uint32_t> count { 0u };
+    std::vector<std::thread> thrs;
+    for (int t = 0; t < num_threads; ++t) {
+      thrs.emplace_back([&ring] {
+        for (std::uint32_t i = 1u; i <= per_thread; ++i) {
+          while (!ring.try_push(bytes_of(i))) {
+            std::this_thread::yield();
+          }
+        }
+      } );
+      thrs.emplace_back([&ring, &sum, &count] {
+        while (count.load() < num_threads * per_thread) {
+          if (auto msg = ring.try_pop()) {
+            sum += value_of(*msg);
+            ++count;
+          }
+          else {
+            std::this_thread::yield();
+          }
+        }
+      } );
+    }
+    for (auto& thr : thrs) {
+      thr.join();
+    }
+    REQUIRE (count.load() == num_threads * per_thread);
+    REQUIRE (sum.load() == std::uint64_t(num_threads) * per_thread * (per_thread + 1u) / 2u);
+  }
+}
+
@@ -0,0 +1,76 @@
+/** @file
+ *
+ * @brief Test scenarios for @c static_shared_buffer and @c make_static_shared_buffer.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#define SHARED_BUFFER_ENABLE_STATS // to check that nothing is allocated
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef> // std::byte
+#include <array>
+#include <optional>
+
+#include "buffer/static_shared_buffer.hpp"
+#include "buffer/shared_buffer.hpp"
+#include "buffer/shared_buffer_sequence.hpp"
+
+#include "utility/byte_array.hpp"
+
+namespace {
+
+constexpr chops::static_shared_buffer pong { "PONG\r\n" };
+constexpr chops::static_shared_buffer hdr { chops::make_byte_array(0xde, 0xad, 0xbe, 0xef) };
+
+static_assert(pong.size() == 6u);
+static_assert(pong.data()[0] == std::byte{'P'});
+static_assert(hdr.size() == 4u);
+static_assert(hdr == chops::static_shared_buffer { chops::make_byte_array(0xde, 0xad, 0xbe, 0xef) });
+
+constexpr std::array<std::byte, 3u> raw { std::byte{0x01}, std::byte{0x02}, std::byte{0x03} };
+
+}
+
+TEST_CASE ( "Static shared buffer",
+            "[static_shared_buffer]" ) {
+
+  chops::reset_shared_buffer_stats();
+  auto before { chops::shared_buffer_stats_snapshot() };
+
+  {
+    auto csb { pong.share() };
+    REQUIRE (csb.size() == 6u);
+    REQUIRE (csb.data() == pong.data()); // no copy
+    std::optional<chops::const_shared_buffer> cp;
+    cp.emplace(csb);
+    auto sl { csb.slice(1u, 3u) };
+    REQUIRE (sl.data() == pong.data() + 1);
+    REQUIRE (sl.size() == 3u);
+
+    auto rs { chops::make_static_shared_buffer(std::span<const std::byte, 3u>(raw)) };
+    REQUIRE (rs.data() == raw.data());
+    REQUIRE (rs.size() == 3u);
+    REQUIRE_FALSE (std::move(*cp).try_reclaim()); // not owned, cannot be reclaimed
+
+    chops::shared_buffer_sequence seq { hdr.share(), pong.share() };
+    REQUIRE (seq.total_size() == 10u);
+    REQUIRE (seq[0].data() == hdr.data());
+  }
+  auto after { chops::shared_buffer_stats_snapshot() };
+  REQUIRE (after.allocations == before.allocations);
+  REQUIRE (after.live_buffers == before.live_buffers);
+
+  // still compares and hashes like any other const_shared_buffer
+  chops::const_shared_buffer heap(pong.data(), pong.size());
+  REQUIRE (heap == pong.share());
+  REQUIRE (heap.hash() == pong.share().hash());
+  REQUIRE (chops::static_shared_buffer { "" }.share().empty());
+}